@@ -136,7 +136,10 @@ const char *glow_code_read_str(GlowCode *code)
 {
 	const char *start = (const char *)code->bc;
 
-	while (*(code->bc++) != '\0');
+	while (*(code->bc++) != '\0') {
+		--code->size;
+	}
+	--code->size;
 
 	return start;
 }
@@ -16,7 +16,6 @@ struct metadata {
 	size_t bc_size;
 	size_t lno_table_size;
 	unsigned int max_vstack_depth;
-	unsigned int max_try_catch_depth;
 };
 
 #define LBI_INIT_CAPACITY 5
@@ -99,6 +98,7 @@ static GlowOpcode to_opcode(GlowNodeType type);
 
 #define DEFAULT_BC_CAPACITY        100
 #define DEFAULT_LNO_TABLE_CAPACITY 30
+#define DEFAULT_EXC_TABLE_CAPACITY 8
 
 static GlowCompiler *compiler_new(const char *filename, unsigned int first_lineno, GlowSymTable *st)
 {
@@ -108,8 +108,9 @@ static GlowCompiler *compiler_new(const char *filename, unsigned int first_linen
 	compiler->lbi = NULL;
 	compiler->st = st;
 	compiler->ct = glow_ct_new();
-	compiler->try_catch_depth = 0;
-	compiler->try_catch_depth_max = 0;
+	glow_code_init(&compiler->exc_table, DEFAULT_EXC_TABLE_CAPACITY);
+	compiler->bc_start = 0;
+	compiler->block_stack_depth = 0;
 	glow_code_init(&compiler->lno_table, DEFAULT_LNO_TABLE_CAPACITY);
 	compiler->first_lineno = first_lineno;
 	compiler->first_ins_on_line_idx = 0;
@@ -131,6 +132,7 @@ static void compiler_free(GlowCompiler *compiler, bool free_st)
 	glow_ct_free(compiler->ct);
 	glow_code_dealloc(&compiler->code);
 	glow_code_dealloc(&compiler->lno_table);
+	glow_code_dealloc(&compiler->exc_table);
 	free(compiler);
 }
 
@@ -226,7 +228,7 @@ static void compile_export(GlowCompiler *compiler, GlowAST *ast);
 
 static void compile_get_attr(GlowCompiler *compiler, GlowAST *ast);
 
-static int max_stack_depth(byte *bc, size_t len);
+static int max_stack_depth(byte *bc, size_t len, const GlowCode *exc_table);
 
 static struct metadata compile_raw(GlowCompiler *compiler, GlowProgram *program, bool is_single_expr)
 {
@@ -239,6 +241,7 @@ static struct metadata compile_raw(GlowCompiler *compiler, GlowProgram *program,
 	write_const_table(compiler);
 
 	const size_t start_size = compiler->code.size;
+	compiler->bc_start = start_size;
 
 	for (struct glow_ast_list *node = program; node != NULL; node = node->next) {
 		compile_node(compiler, node->ast, !is_single_expr);
@@ -255,6 +258,7 @@ static struct metadata compile_raw(GlowCompiler *compiler, GlowProgram *program,
 
 	GlowCode *code = &compiler->code;
 	GlowCode *lno_table = &compiler->lno_table;
+	GlowCode *exc_table = &compiler->exc_table;
 
 	/* two zeros mark the end of the line number table */
 	glow_code_write_byte(lno_table, 0);
@@ -262,22 +266,24 @@ static struct metadata compile_raw(GlowCompiler *compiler, GlowProgram *program,
 
 	const size_t final_size = code->size;
 	const size_t bc_size = final_size - start_size;
-	unsigned int max_vstack_depth = max_stack_depth(code->bc, code->size);
-	unsigned int max_try_catch_depth = compiler->try_catch_depth_max;
+	unsigned int max_vstack_depth = max_stack_depth(code->bc, code->size, exc_table);
 
 	/*
 	 * What follows is somewhat delicate: we want the line number
-	 * table to come before the symbol/constant tables in the compiled
-	 * code, but we do not have a completed line number table until
-	 * compilation is complete, so we copy everything into a new Code
-	 * instance and use that as our finished product.
+	 * and exception handler tables to come before the symbol/constant
+	 * tables in the compiled code, but we do not have completed tables
+	 * until compilation is complete, so we copy everything into a new
+	 * Code instance and use that as our finished product.
 	 */
 	const size_t lno_table_size = lno_table->size;
+	const size_t exc_table_size = exc_table->size;
 	GlowCode complete;
-	glow_code_init(&complete, 2 + 2 + lno_table_size + final_size);
+	glow_code_init(&complete, 2 + 2 + lno_table_size + 2 + exc_table_size + final_size);
 	glow_code_write_uint16(&complete, compiler->first_lineno);
 	glow_code_write_uint16(&complete, lno_table_size);
 	glow_code_append(&complete, lno_table);
+	glow_code_write_uint16(&complete, exc_table_size / GLOW_EXC_TABLE_ENTRY_SIZE);
+	glow_code_append(&complete, exc_table);
 	glow_code_append(&complete, code);
 	glow_code_dealloc(code);
 	compiler->code = complete;
@@ -287,7 +293,6 @@ static struct metadata compile_raw(GlowCompiler *compiler, GlowProgram *program,
 	metadata.bc_size = bc_size;
 	metadata.lno_table_size = lno_table_size;
 	metadata.max_vstack_depth = max_vstack_depth;
-	metadata.max_try_catch_depth = max_try_catch_depth;
 	return metadata;
 }
 
@@ -450,11 +455,62 @@ static void compile_assignment(GlowCompiler *compiler, GlowAST *ast)
 	}
 }
 
+static const struct {
+	const char *name;
+	GlowOpcode opcode;
+} intrinsics[] = {
+	{"len",  GLOW_INS_LEN},
+	{"hash", GLOW_INS_HASH},
+	{"str",  GLOW_INS_STR},
+	{"type", GLOW_INS_TYPE},
+	{"iter", GLOW_INS_GET_ITER},
+	{"next", GLOW_INS_NEXT},
+	{NULL,   GLOW_INS_NOP}
+};
+
+/*
+ * Returns the intrinsic opcode for `ast` if it is a call of a builtin
+ * with one unnamed argument, or GLOW_INS_NOP otherwise. Free variables
+ * can only ever refer to builtins, so a name that isn't bound locally
+ * or globally is never shadowed.
+ */
+static GlowOpcode call_intrinsic(GlowCompiler *compiler, GlowAST *ast)
+{
+	struct glow_ast_list *params = ast->v.params;
+
+	if (ast->left->type != GLOW_NODE_IDENT ||
+	    params == NULL || params->next != NULL ||
+	    GLOW_NODE_TYPE_IS_ASSIGNMENT(params->ast->type)) {
+		return GLOW_INS_NOP;
+	}
+
+	const GlowSTSymbol *sym = glow_ste_get_symbol(compiler->st->ste_current, ast->left->v.ident);
+
+	if (sym == NULL || !sym->free_var) {
+		return GLOW_INS_NOP;
+	}
+
+	for (size_t i = 0; intrinsics[i].name != NULL; i++) {
+		if (strcmp(ast->left->v.ident->value, intrinsics[i].name) == 0) {
+			return intrinsics[i].opcode;
+		}
+	}
+
+	return GLOW_INS_NOP;
+}
+
 static void compile_call(GlowCompiler *compiler, GlowAST *ast)
 {
 	GLOW_AST_TYPE_ASSERT(ast, GLOW_NODE_CALL);
 
 	const unsigned int lineno = ast->lineno;
+	const GlowOpcode intrinsic = call_intrinsic(compiler, ast);
+
+	if (intrinsic != GLOW_INS_NOP) {
+		compile_node(compiler, ast->v.params->ast, false);
+		write_ins(compiler, intrinsic, lineno);
+		return;
+	}
 
 	unsigned int unnamed_args = 0;
 	unsigned int named_args = 0;
@@ -486,8 +542,20 @@ static void compile_call(GlowCompiler *compiler, GlowAST *ast)
 
 	assert(unnamed_args <= 0xff && named_args <= 0xff);
 
-	compile_node(compiler, ast->left, false);  // callable
-	write_ins(compiler, GLOW_INS_CALL, lineno);
+	if (ast->left->type == GLOW_NODE_DOT) {
+		/* method call: push the receiver and method instead of a bound method */
+		GlowStr *attr = ast->left->right->v.ident;
+		GlowSTSymbol *attr_sym = glow_ste_get_attr_symbol(compiler->st->ste_current, attr);
+
+		compile_node(compiler, ast->left->left, false);  // receiver
+		write_ins(compiler, GLOW_INS_LOAD_METHOD, lineno);
+		write_uint16(compiler, attr_sym->id);
+		write_ins(compiler, GLOW_INS_CALL_METHOD, lineno);
+	} else {
+		compile_node(compiler, ast->left, false);  // callable
+		write_ins(compiler, GLOW_INS_CALL, lineno);
+	}
+
 	write_uint16(compiler, (named_args << 8) | unnamed_args);
 }
 
@@ -713,12 +781,23 @@ static void compile_for(GlowCompiler *compiler, GlowAST *ast)
 	GlowAST *iter = ast->right;
 	GlowAST *body = ast->v.middle;
 
-	compile_node(compiler, iter, false);
-	write_ins(compiler, GLOW_INS_GET_ITER, lineno);
+	/* `for i in a..b` counts on the stack rather than iterating a range */
+	const bool int_range = (iter->type == GLOW_NODE_DOTDOT && lcv->type == GLOW_NODE_IDENT);
+	const unsigned int stack_items = int_range ? 2 : 1;
+
+	if (int_range) {
+		compile_node(compiler, iter->left, false);
+		compile_node(compiler, iter->right, false);
+		write_ins(compiler, GLOW_INS_SETUP_RANGE, iter->lineno);
+	} else {
+		compile_node(compiler, iter, false);
+		write_ins(compiler, GLOW_INS_GET_ITER, lineno);
+	}
 
 	const size_t loop_start_index = compiler->code.size;
 	compiler_push_loop(compiler, loop_start_index);
-	write_ins(compiler, GLOW_INS_LOOP_ITER, iter->lineno);
+	compiler->block_stack_depth += stack_items;
+	write_ins(compiler, int_range ? GLOW_INS_FOR_RANGE : GLOW_INS_LOOP_ITER, iter->lineno);
 
 	// jump placeholder:
 	const size_t jump_index = compiler->code.size;
@@ -773,8 +852,12 @@ static void compile_for(GlowCompiler *compiler, GlowAST *ast)
 	write_uint16_at(compiler, compiler->code.size - jump_index - 2, jump_index);
 
 	compiler_pop_loop(compiler);
+	compiler->block_stack_depth -= stack_items;
 
-	write_ins(compiler, GLOW_INS_POP, 0);  // pop the iterator left behind by GET_ITER
+	// pop the iterator left behind by GET_ITER (or the counter and its end):
+	for (unsigned int i = 0; i < stack_items; i++) {
+		write_ins(compiler, GLOW_INS_POP, 0);
+	}
 }
 
 #define COMPILE_DEF 0
@@ -979,7 +1062,13 @@ static void compile_receive(GlowCompiler *compiler, GlowAST *ast)
 		GLOW_INTERNAL_ERROR();
 	}
 
-	write_ins(compiler, GLOW_INS_RECEIVE, lineno);
+	if (ast->right != NULL) {
+		compile_node(compiler, ast->right, false);
+		write_ins(compiler, GLOW_INS_RECEIVE_BATCH, lineno);
+	} else {
+		write_ins(compiler, GLOW_INS_RECEIVE, lineno);
+	}
+
 	write_ins(compiler, GLOW_INS_STORE, lineno);
 	write_uint16(compiler, sym->id);
 }
@@ -987,7 +1076,6 @@ static void compile_receive(GlowCompiler *compiler, GlowAST *ast)
 static void compile_try_catch(GlowCompiler *compiler, GlowAST *ast)
 {
 	GLOW_AST_TYPE_ASSERT(ast, GLOW_NODE_TRY_CATCH);
-	const unsigned int try_lineno = ast->lineno;
 	const unsigned int catch_lineno = ast->right->lineno;
 
 	unsigned int exc_count = 0;
@@ -998,29 +1086,28 @@ static void compile_try_catch(GlowCompiler *compiler, GlowAST *ast)
 	assert(exc_count == 1);  // TODO: handle 2+ exceptions (this is currently valid syntactically)
 
 	/* === Try Block === */
-	write_ins(compiler, GLOW_INS_TRY_BEGIN, try_lineno);
-	const size_t try_block_size_index = compiler->code.size;
-	write_uint16(compiler, 0);  /* placeholder for try-length */
-	const size_t handler_offset_index = compiler->code.size;
-	write_uint16(compiler, 0);  /* placeholder for handler offset */
-
-	compiler->try_catch_depth += exc_count;
-
-	if (compiler->try_catch_depth > compiler->try_catch_depth_max) {
-		compiler->try_catch_depth_max = compiler->try_catch_depth;
-	}
-
+	const size_t try_start = compiler->code.size;
 	compile_node(compiler, ast->left, true);  /* try block */
-	compiler->try_catch_depth -= exc_count;
-
-	write_ins(compiler, GLOW_INS_TRY_END, catch_lineno);
-	write_uint16_at(compiler, compiler->code.size - try_block_size_index - 4, try_block_size_index);
+	const size_t try_end = compiler->code.size;
 
 	write_ins(compiler, GLOW_INS_JMP, catch_lineno);  /* jump past exception handlers if no exception was thrown */
 	const size_t jmp_over_handlers_index = compiler->code.size;
 	write_uint16(compiler, 0);  /* placeholder for jump offset */
 
-	write_uint16_at(compiler, compiler->code.size - handler_offset_index - 2, handler_offset_index);
+	/*
+	 * Nothing is executed on entry to the try block; instead, we record
+	 * the block in the exception handler table, which the VM consults
+	 * only once an exception is actually thrown. Any try blocks nested
+	 * in this one have already been recorded by this point, so the table
+	 * is ordered innermost-first, and the first entry that covers the
+	 * faulting instruction is the right one.
+	 */
+	const size_t handler_start = compiler->code.size;
+	GlowCode *exc_table = &compiler->exc_table;
+	glow_code_write_uint16(exc_table, try_start - compiler->bc_start);
+	glow_code_write_uint16(exc_table, try_end - compiler->bc_start);
+	glow_code_write_uint16(exc_table, handler_start - compiler->bc_start);
+	glow_code_write_uint16(exc_table, compiler->block_stack_depth);
 
 	/* === Handler === */
 	write_ins(compiler, GLOW_INS_DUP, catch_lineno);
@@ -1473,9 +1560,9 @@ static void write_const_table(GlowCompiler *compiler)
 
 			/*
 			 * Write size of actual CodeObject bytecode, excluding
-			 * metadata (name, argcount, stack_depth, try_catch_depth):
+			 * metadata (name, argcount, stack_depth):
 			 */
-			write_uint16(compiler, co_code->size - (name_len + 1) - 2 - 2 - 2);
+			write_uint16(compiler, co_code->size - (name_len + 1) - 2 - 2);
 
 			append(compiler, co_code);
 			glow_code_dealloc(co_code);
@@ -1564,7 +1651,6 @@ static void fill_ct_from_ast(GlowCompiler *compiler, GlowAST *ast)
 		GlowCode *subcode = &sub->code;
 
 		const unsigned int max_vstack_depth = metadata.max_vstack_depth;
-		const unsigned int max_try_catch_depth = metadata.max_try_catch_depth;
 
 		GlowCode *fncode = glow_malloc(sizeof(GlowCode));
 
@@ -1572,11 +1658,10 @@ static void fill_ct_from_ast(GlowCompiler *compiler, GlowAST *ast)
 		GlowStr name = (def_or_gen_or_act ? *ast->left->v.ident : GLOW_STR_INIT(LAMBDA, strlen(LAMBDA), 0));
 #undef LAMBDA
 
-		glow_code_init(fncode, (name.len + 1) + 2 + 2 + 2 + subcode->size);  // total size
-		glow_code_write_str(fncode, &name);                                  // name
-		glow_code_write_uint16(fncode, nargs);                               // argument count
-		glow_code_write_uint16(fncode, max_vstack_depth);                    // max stack depth
-		glow_code_write_uint16(fncode, max_try_catch_depth);                 // max try-catch depth
+		glow_code_init(fncode, (name.len + 1) + 2 + 2 + subcode->size);  // total size
+		glow_code_write_str(fncode, &name);                              // name
+		glow_code_write_uint16(fncode, nargs);                           // argument count
+		glow_code_write_uint16(fncode, max_vstack_depth);                // max stack depth
 		glow_code_append(fncode, subcode);
 
 		compiler_free(sub, false);
@@ -1656,7 +1741,7 @@ static void fill_ct(GlowCompiler *compiler, GlowProgram *program)
 static int stack_delta(GlowOpcode opcode, int arg);
 static int read_arg(GlowOpcode opcode, byte **bc);
 
-static int max_stack_depth(byte *bc, size_t len)
+static int max_stack_depth(byte *bc, size_t len, const GlowCode *exc_table)
 {
 	const byte *end = bc + len;
 
@@ -1715,7 +1800,6 @@ static int max_stack_depth(byte *bc, size_t len)
 				while (*bc++ != '\0');  // name
 				bc += 2;  // arg count
 				bc += 2;  // stack depth
-				bc += 2;  // try-catch depth
 
 				for (size_t i = 0; i < colen; i++) {
 					++bc;
@@ -1732,10 +1816,23 @@ static int max_stack_depth(byte *bc, size_t len)
 	 * Begin max depth computation...
 	 */
 
+	const byte *bc_start = bc;
+	const size_t n_handlers = exc_table->size / GLOW_EXC_TABLE_ENTRY_SIZE;
+
 	int depth = 0;
 	int max_depth = 0;
 
 	while (bc != end) {
+		/* the VM pushes the exception before jumping to a handler */
+		for (size_t i = 0; i < n_handlers; i++) {
+			const size_t handler = glow_util_read_uint16_from_stream(&exc_table->bc[i*GLOW_EXC_TABLE_ENTRY_SIZE + 4]);
+
+			if (handler == (size_t)(bc - bc_start)) {
+				++depth;
+				break;
+			}
+		}
+
 		byte opcode = *bc++;
 
 		int arg = read_arg(opcode, &bc);
@@ -1831,10 +1928,6 @@ int glow_opcode_arg_size(GlowOpcode opcode)
 	case GLOW_INS_THROW:
 	case GLOW_INS_PRODUCE:
 		return 0;
-	case GLOW_INS_TRY_BEGIN:
-		return 4;
-	case GLOW_INS_TRY_END:
-		return 0;
 	case GLOW_INS_JMP_IF_EXC_MISMATCH:
 		return 2;
 	case GLOW_INS_MAKE_LIST:
@@ -1848,22 +1941,52 @@ int glow_opcode_arg_size(GlowOpcode opcode)
 	case GLOW_INS_EXPORT_NAME:
 		return 2;
 	case GLOW_INS_RECEIVE:
+	case GLOW_INS_RECEIVE_BATCH:
 		return 0;
 	case GLOW_INS_GET_ITER:
 		return 0;
 	case GLOW_INS_LOOP_ITER:
 		return 2;
+	case GLOW_INS_SETUP_RANGE:
+		return 0;
+	case GLOW_INS_FOR_RANGE:
+		return 2;
 	case GLOW_INS_MAKE_FUNCOBJ:
 	case GLOW_INS_MAKE_GENERATOR:
 	case GLOW_INS_MAKE_ACTOR:
 		return 2;
 	case GLOW_INS_SEQ_EXPAND:
+	case GLOW_INS_LOAD_METHOD:
+	case GLOW_INS_CALL_METHOD:
 		return 2;
+	case GLOW_INS_LEN:
+	case GLOW_INS_HASH:
+	case GLOW_INS_STR:
+	case GLOW_INS_TYPE:
+	case GLOW_INS_NEXT:
 	case GLOW_INS_POP:
 	case GLOW_INS_DUP:
 	case GLOW_INS_DUP_TWO:
 	case GLOW_INS_ROT:
 	case GLOW_INS_ROT_THREE:
+	case GLOW_INS_ADD_INT_INT:
+	case GLOW_INS_SUB_INT_INT:
+	case GLOW_INS_MUL_INT_INT:
+	case GLOW_INS_MOD_INT_INT:
+	case GLOW_INS_EQUAL_INT_INT:
+	case GLOW_INS_NOTEQ_INT_INT:
+	case GLOW_INS_LT_INT_INT:
+	case GLOW_INS_GT_INT_INT:
+	case GLOW_INS_LE_INT_INT:
+	case GLOW_INS_GE_INT_INT:
+	case GLOW_INS_ADD_FLOAT_FLOAT:
+	case GLOW_INS_SUB_FLOAT_FLOAT:
+	case GLOW_INS_MUL_FLOAT_FLOAT:
+	case GLOW_INS_DIV_FLOAT_FLOAT:
+	case GLOW_INS_LT_FLOAT_FLOAT:
+	case GLOW_INS_GT_FLOAT_FLOAT:
+	case GLOW_INS_LE_FLOAT_FLOAT:
+	case GLOW_INS_GE_FLOAT_FLOAT:
 		return 0;
 	default:
 		return -1;
@@ -1999,10 +2122,6 @@ static int stack_delta(GlowOpcode opcode, int arg)
 	case GLOW_INS_THROW:
 	case GLOW_INS_PRODUCE:
 		return -1;
-	case GLOW_INS_TRY_BEGIN:
-		return 0;
-	case GLOW_INS_TRY_END:
-		return 1;  // technically 0 but exception should be on stack before reaching handlers
 	case GLOW_INS_JMP_IF_EXC_MISMATCH:
 		return -2;
 	case GLOW_INS_MAKE_LIST:
@@ -2018,10 +2137,16 @@ static int stack_delta(GlowOpcode opcode, int arg)
 		return -1;
 	case GLOW_INS_RECEIVE:
 		return 1;
+	case GLOW_INS_RECEIVE_BATCH:
+		return 0;
 	case GLOW_INS_GET_ITER:
 		return 0;
 	case GLOW_INS_LOOP_ITER:
 		return 1;
+	case GLOW_INS_SETUP_RANGE:
+		return 0;
+	case GLOW_INS_FOR_RANGE:
+		return 1;
 	case GLOW_INS_MAKE_FUNCOBJ:
 	case GLOW_INS_MAKE_GENERATOR:
 	case GLOW_INS_MAKE_ACTOR:
@@ -2037,6 +2162,35 @@ static int stack_delta(GlowOpcode opcode, int arg)
 	case GLOW_INS_ROT:
 	case GLOW_INS_ROT_THREE:
 		return 0;
+	case GLOW_INS_LOAD_METHOD:
+		return 1;
+	case GLOW_INS_CALL_METHOD:
+		return -((arg & 0xff) + 2*(arg >> 8)) - 1;
+	case GLOW_INS_LEN:
+	case GLOW_INS_HASH:
+	case GLOW_INS_STR:
+	case GLOW_INS_TYPE:
+	case GLOW_INS_NEXT:
+		return 0;
+	case GLOW_INS_ADD_INT_INT:
+	case GLOW_INS_SUB_INT_INT:
+	case GLOW_INS_MUL_INT_INT:
+	case GLOW_INS_MOD_INT_INT:
+	case GLOW_INS_EQUAL_INT_INT:
+	case GLOW_INS_NOTEQ_INT_INT:
+	case GLOW_INS_LT_INT_INT:
+	case GLOW_INS_GT_INT_INT:
+	case GLOW_INS_LE_INT_INT:
+	case GLOW_INS_GE_INT_INT:
+	case GLOW_INS_ADD_FLOAT_FLOAT:
+	case GLOW_INS_SUB_FLOAT_FLOAT:
+	case GLOW_INS_MUL_FLOAT_FLOAT:
+	case GLOW_INS_DIV_FLOAT_FLOAT:
+	case GLOW_INS_LT_FLOAT_FLOAT:
+	case GLOW_INS_GT_FLOAT_FLOAT:
+	case GLOW_INS_LE_FLOAT_FLOAT:
+	case GLOW_INS_GE_FLOAT_FLOAT:
+		return -1;
 	}
 
 	GLOW_INTERNAL_ERROR();
@@ -2060,8 +2214,7 @@ void glow_compile(const char *name, GlowProgram *prog, FILE *out)
 	/*
 	 * Directly after the magic bytes, we write
 	 * the maximum value stack depth at module
-	 * level, followed by the maximum try-catch
-	 * depth:
+	 * level:
 	 */
 	byte buf[2];
 
@@ -2070,11 +2223,6 @@ void glow_compile(const char *name, GlowProgram *prog, FILE *out)
 		fputc(buf[i], out);
 	}
 
-	glow_util_write_uint16_to_stream(buf, metadata.max_try_catch_depth);
-	for (size_t i = 0; i < sizeof(buf); i++) {
-		fputc(buf[i], out);
-	}
-
 	/*
 	 * And now we write the actual bytecode:
 	 */
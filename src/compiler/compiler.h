@@ -10,6 +10,14 @@
 extern const byte glow_magic[];
 extern const size_t glow_magic_size;
 
+/*
+ * Exception handler table entries consist of four uint16s:
+ * try block start, try block end, handler position and the
+ * value stack depth to unwind to. Positions are relative to
+ * the first instruction of the code object.
+ */
+#define GLOW_EXC_TABLE_ENTRY_SIZE 8
+
 /*
  * The following structure is used for
  * continue/break bookkeeping.
@@ -31,8 +39,14 @@ typedef struct {
 	GlowSymTable *st;
 	GlowConstTable *ct;
 
-	unsigned int try_catch_depth;
-	unsigned int try_catch_depth_max;
+	/* exception handler table; see compile_try_catch() */
+	GlowCode exc_table;
+
+	/* offset of the first instruction, past the symbol and constant tables */
+	size_t bc_start;
+
+	/* values left on the value stack by enclosing blocks (e.g. for-loop iterators) */
+	unsigned int block_stack_depth;
 
 	GlowCode lno_table;
 	unsigned int first_lineno;
@@ -1236,7 +1236,19 @@ static GlowAST *parse_receive(GlowParser *p)
 
 	GlowAST *ident = parse_ident(p);
 	ERROR_CHECK(p);
-	GlowAST *ast = glow_ast_new(GLOW_NODE_RECEIVE, ident, NULL, tok->lineno);
+
+	/* `receive msgs, n` takes a list of up to `n` messages */
+	GlowAST *count = NULL;
+	GlowToken *peek = glow_parser_peek_token(p);
+
+	if (peek->type == GLOW_TOK_COMMA) {
+		expect(p, GLOW_TOK_COMMA);
+		ERROR_CHECK_AST(p, NULL, ident);
+		count = parse_expr_no_assign(p);
+		ERROR_CHECK_AST(p, count, ident);
+	}
+
+	GlowAST *ast = glow_ast_new(GLOW_NODE_RECEIVE, ident, count, tok->lineno);
 	return ast;
 }
 
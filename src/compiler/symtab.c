@@ -595,7 +595,7 @@ static void ste_add_child(GlowSTEntry *ste, GlowSTEntry *child)
 
 	if (ste->n_children == ste->children_capacity) {
 		ste->children_capacity = (ste->children_capacity * 3)/2 + 1;
-		ste->children = glow_realloc(ste->children, ste->children_capacity);
+		ste->children = glow_realloc(ste->children, ste->children_capacity * sizeof(GlowSTEntry *));
 	}
 
 	ste->children[ste->n_children++] = child;
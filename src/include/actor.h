@@ -2,30 +2,67 @@
 #define GLOW_ACTOR_H
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <stdatomic.h>
 #include <pthread.h>
 #include "object.h"
+#include "listobject.h"
 #include "codeobject.h"
 #include "vm.h"
+#include "scheduler.h"
 #include "err.h"
 
+/* embedded in each GlowMessage, so queueing one allocates nothing */
 struct glow_mailbox_node {
-	GlowValue value;
-	struct glow_mailbox_node *volatile next;
+	_Atomic(struct glow_mailbox_node *) next;
+};
+
+/* what senders do when a bounded mailbox is full */
+enum glow_mailbox_policy {
+	GLOW_MAILBOX_BLOCK,
+	GLOW_MAILBOX_FAIL,
+	GLOW_MAILBOX_DROP_OLDEST
 };
 
+/*
+ * Vyukov's intrusive multi-producer single-consumer queue: any thread
+ * pushes with a single exchange, only the actor itself pops. The mutex
+ * and condition are only used by the actor once it finds the mailbox
+ * empty, and by senders seeing it waiting.
+ *
+ * Queued messages are counted for monitoring and bounding; blocked
+ * senders wait on `not_full`. Under GLOW_MAILBOX_DROP_OLDEST senders pop the oldest
+ * message themselves, so every pop then happens with the mutex held.
+ */
 struct glow_mailbox {
-	struct glow_mailbox_node *volatile head;
-	struct glow_mailbox_node *tail;
+	_Atomic(struct glow_mailbox_node *) head;  /* most recently pushed */
+	atomic_size_t pushed;                       /* claimed by senders */
+	struct glow_mailbox_node *tail;             /* next to pop */
+	atomic_size_t popped;                       /* advanced by whoever holds `tail` */
+	struct glow_mailbox_node stub;
 
+	atomic_bool waiting;
 	pthread_mutex_t mutex;
-	pthread_cond_t cond;
+	struct glow_sched_cond cond;
+
+	size_t capacity;  /* 0 = unbounded */
+	enum glow_mailbox_policy policy;
+	atomic_size_t high_water;
+	atomic_uint blocked;
+	struct glow_sched_cond not_full;
 };
 
 void glow_mailbox_init(struct glow_mailbox *mb);
-void glow_mailbox_push(struct glow_mailbox *mb, GlowValue *v);
+/* only before the mailbox is in use */
+void glow_mailbox_set_capacity(struct glow_mailbox *mb, const size_t capacity, const enum glow_mailbox_policy policy);
+/* `v` must be a Message; false if the mailbox is full under GLOW_MAILBOX_FAIL */
+bool glow_mailbox_push(struct glow_mailbox *mb, GlowValue *v);
+bool glow_mailbox_push_batch(struct glow_mailbox *mb, GlowValue *msgs, const size_t n);
 GlowValue glow_mailbox_pop(struct glow_mailbox *mb);
 GlowValue glow_mailbox_pop_nowait(struct glow_mailbox *mb);
+void glow_mailbox_drain(struct glow_mailbox *mb, GlowListObject *list, size_t max);
+size_t glow_mailbox_depth(struct glow_mailbox *mb);
+size_t glow_mailbox_high_water(struct glow_mailbox *mb);
 void glow_mailbox_dealloc(struct glow_mailbox *mb);
 
 extern GlowClass glow_actor_proxy_class;
@@ -48,7 +85,11 @@ typedef struct glow_actor_object {
 	GlowVM *vm;
 	GlowValue retval;
 
-	pthread_t thread;
+	struct glow_task task;
+
+	/* guards `state` once the actor has started */
+	pthread_mutex_t mutex;
+	struct glow_sched_cond finished;
 
 	enum {
 		GLOW_ACTOR_STATE_READY,
@@ -58,20 +99,22 @@ typedef struct glow_actor_object {
 
 	struct glow_actor_object *prev;
 	struct glow_actor_object *next;
+	bool linked;
 } GlowActorObject;
 
 typedef struct {
 	GlowObject base;
 
 	GlowValue value;
-	pthread_mutex_t mutex;
-	pthread_cond_t cond;
+	atomic_uint_least64_t state;  /* see future_finish() */
 } GlowFutureObject;
 
 typedef struct {
 	GlowObject base;
+	struct glow_mailbox_node node;
 	GlowValue contents;  /* empty contents = kill message */
-	GlowFutureObject *future;
+	GlowFutureObject *future;  /* NULL for told messages */
+	bool replied;
 } GlowMessage;
 
 GlowValue glow_actor_proxy_make(GlowCodeObject *co);
@@ -80,7 +123,7 @@ void glow_actor_proxy_init_defaults(GlowActorProxy *ap, GlowValue *defaults, con
 void glow_actor_join_all(void);
 
 GlowValue glow_future_make(void);
-GlowValue glow_message_make(GlowValue *contents);
+GlowValue glow_message_make(GlowValue *contents, const bool with_future);
 GlowValue glow_kill_message_make(void);
 
 #endif /* GLOW_ACTOR_H */
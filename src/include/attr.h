@@ -49,6 +49,16 @@ struct glow_attr_method {
 	const MethodFunc meth;
 };
 
+/*
+ * Functions reached through the class itself (e.g. `Future.all`)
+ * are delineated via an array of this structure:
+ */
+struct glow_native_func_object;
+struct glow_attr_static {
+	const char *name;
+	struct glow_native_func_object *func;
+};
+
 typedef struct glow_attr_dict_entry {
 	const char *key;
 	unsigned int value;
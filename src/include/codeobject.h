@@ -11,9 +11,43 @@ struct glow_frame;
 
 extern GlowClass glow_co_class;
 
+/*
+ * Entry of a code object's exception handler table. An exception
+ * thrown by an instruction in [start, end) is handled by jumping
+ * to `handler` once the value stack has been unwound to `depth`.
+ */
+struct glow_exc_handler {
+	unsigned int start;
+	unsigned int end;
+	unsigned int handler;
+	unsigned int depth;
+};
+
 struct glow_code_cache {
 	/* line number cache */
 	unsigned int lineno;
+
+	/* quickening: generic opcode of a specialized instruction */
+	_Atomic byte generic_op;
+
+	/* quickening: executions to wait before specializing again */
+	_Atomic byte backoff;
+
+	/* 1 + index into the code object's `attr_caches`, or 0 */
+	unsigned short attr_cache;
+};
+
+/*
+ * Polymorphic inline cache of a LOAD_ATTR/SET_ATTR/LOAD_METHOD instruction,
+ * mapping receiver classes to attribute dictionary values. Entries
+ * are filled at most once (under a lock, class last), so a reader
+ * that sees a class also sees its value; a full cache is left alone.
+ */
+#define GLOW_ATTR_CACHE_SIZE 4
+
+struct glow_attr_cache {
+	_Atomic(GlowClass *) classes[GLOW_ATTR_CACHE_SIZE];
+	unsigned int values[GLOW_ATTR_CACHE_SIZE];
 };
 
 typedef struct {
@@ -31,9 +65,6 @@ typedef struct {
 	/* max value stack depth */
 	unsigned int stack_depth;
 
-	/* max try-catch depth */
-	unsigned int try_catch_depth;
-
 	/* enumerated variable names */
 	struct glow_str_array names;
 
@@ -43,12 +74,23 @@ typedef struct {
 	/* enumerated free variables */
 	struct glow_str_array frees;
 
+	/* `attrs` and `frees` as pre-hashed strings, for dictionary lookups */
+	GlowStr *attr_keys;
+	GlowStr *free_keys;
+
+	/* builtins bound to `frees` at load (empty if unbound), read by LOAD_NAME */
+	GlowValue *free_values;
+
 	/* enumerated constants */
 	struct glow_value_array consts;
 
 	/* type hints */
 	GlowClass **hints;
 
+	/* exception handler table, innermost handlers first */
+	struct glow_exc_handler *exc_handlers;
+	unsigned int n_exc_handlers;
+
 	/* line number table */
 	byte *lno_table;
 
@@ -59,20 +101,22 @@ typedef struct {
 	struct glow_vm *vm;
 
 	/* caches */
-	struct glow_frame *frame;
+	struct glow_frame *frame_pool;  /* see get_frame() in vm.c */
+	unsigned int frame_pool_size;
+	atomic_flag frame_pool_lock;
 	struct glow_code_cache *cache;
+	struct glow_attr_cache *attr_caches;
 } GlowCodeObject;
 
 GlowCodeObject *glow_codeobj_make(GlowCode *code,
                                 const char *name,
                                 unsigned int argcount,
                                 int stack_depth,
-                                int try_catch_depth,
                                 struct glow_vm *vm);
 
 /*
- * The stack and try-catch depths must be read out of the given
- * code at the top level.
+ * The stack depth must be read out of the given code
+ * at the top level.
  */
 GlowCodeObject *glow_codeobj_make_toplevel(GlowCode *code,
                                          const char *name,
@@ -9,18 +9,19 @@ extern struct glow_seq_methods glow_dict_seq_methods;
 extern GlowClass glow_dict_class;
 
 struct glow_dict_entry {
-	GlowValue key;
+	GlowValue key;  /* empty if removed */
 	GlowValue value;
 	int hash;
-	struct glow_dict_entry *next;
 };
 
+/* insertion-ordered; see dictobject.c */
 typedef struct {
 	GlowObject base;
-	struct glow_dict_entry **entries;
-	size_t count;
-	size_t capacity;
-	size_t threshold;
+	void *indices;
+	struct glow_dict_entry *entries;  /* same allocation as `indices` */
+	size_t count;      /* number of items */
+	size_t n_entries;  /* used slots of `entries`, including removed items */
+	size_t capacity;   /* number of slots of `indices`; a power of 2 */
 	unsigned state_id;
 	GLOW_SAVED_TID_FIELD
 } GlowDictObject;
@@ -46,7 +47,6 @@ typedef struct {
 	GlowDictObject *source;
 	unsigned saved_state_id;
 	size_t current_index;
-	struct glow_dict_entry *current_entry;
 } GlowDictIter;
 
 #endif /* GLOW_DICT_H */
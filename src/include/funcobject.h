@@ -19,4 +19,11 @@ GlowValue glow_funcobj_make(GlowCodeObject *co);
 
 void glow_funcobj_init_defaults(GlowFuncObject *co, GlowValue *defaults, const size_t n_defaults);
 
+GlowValue glow_funcobj_push_frame(struct glow_vm *vm,
+                                GlowFuncObject *fn,
+                                GlowValue *args,
+                                GlowValue *args_named,
+                                size_t nargs,
+                                size_t nargs_named);
+
 #endif /* GLOW_FUNCOBJECT_H */
@@ -0,0 +1,75 @@
+#ifndef GLOW_GC_H
+#define GLOW_GC_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "object.h"
+
+/*
+ * Generational cycle collector. Reference counting frees everything
+ * except reference cycles; those are found by periodically scanning the
+ * tracked containers (instances of classes with a `traverse` hook) and
+ * clearing any group of them that is referenced only from within itself.
+ *
+ * Each owner (a thread, or a task, see scheduler.h) collects the
+ * containers it owns, so a collection only pauses the one running it. Containers handed to other actors (see
+ * glow_share()), along with the containers they reach at that point,
+ * are untracked and left to reference counting alone.
+ */
+
+#define GLOW_GC_GENERATIONS 3
+
+/* precedes every instance of a class with a `traverse` hook */
+struct glow_gc_head {
+	struct glow_gc_head *prev;
+	struct glow_gc_head *next;  /* NULL if untracked */
+	intptr_t refs;
+	unsigned int generation;
+};
+
+#define GLOW_GC_HEAD(o) (((struct glow_gc_head *)(o)) - 1)
+
+/* `refs` outside of collections */
+#define GLOW_GC_REFS_IDLE (-1)
+
+static inline void glow_gc_head_init(struct glow_gc_head *h)
+{
+	h->prev = h->next = NULL;
+	h->refs = GLOW_GC_REFS_IDLE;
+	h->generation = 0;
+}
+
+struct glow_gc_stats {
+	unsigned long collections[GLOW_GC_GENERATIONS];
+	unsigned long collected;
+
+	/* pauses, in seconds */
+	double last_pause;
+	double max_pause;
+	double total_pause;
+};
+
+void glow_gc_track(void *o);
+void glow_gc_untrack(void *o);
+
+/* collects `generation` and all younger ones; returns # objects freed */
+size_t glow_gc_collect(unsigned int generation);
+
+/* a generation-0 threshold of 0 disables automatic collection */
+void glow_gc_set_threshold(unsigned int generation, unsigned int threshold);
+unsigned int glow_gc_get_threshold(unsigned int generation);
+
+void glow_gc_get_stats(struct glow_gc_stats *stats);
+
+/* must be called by threads (or tasks) that may have tracked objects before they exit */
+void glow_gc_thread_exit(void);
+
+/* the containers of an owner other than the thread itself */
+struct glow_gc_state;
+struct glow_gc_state *glow_gc_state_new(void);
+void glow_gc_state_free(struct glow_gc_state *gc);
+
+/* makes the calling thread track into `gc` (NULL for its own); returns what it tracked into */
+struct glow_gc_state *glow_gc_state_swap(struct glow_gc_state *gc);
+
+#endif /* GLOW_GC_H */
@@ -14,6 +14,9 @@ typedef struct {
 
 GlowValue glow_module_make(const char *name, GlowStrDict *contents);
 
+/* works for built-in modules too; `attr` caches its hash */
+GlowValue glow_module_get_attr(GlowValue *this, GlowStr *attr);
+
 extern GlowClass glow_builtin_module_class;
 
 /* builtins.h */
@@ -11,7 +11,7 @@ extern GlowClass glow_native_func_class;
 
 typedef GlowValue (*GlowNativeFunc)(GlowValue *args, size_t nargs);
 
-typedef struct {
+typedef struct glow_native_func_object {
 	GlowObject base;
 	GlowNativeFunc func;
 } GlowNativeFuncObject;
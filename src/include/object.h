@@ -33,15 +33,107 @@ typedef GlowValue (*GlowSeqSetFunc)(GlowValue *this, GlowValue *idx, GlowValue *
 typedef GlowValue (*GlowAttrGetFunc)(GlowValue *this, const char *attr);
 typedef GlowValue (*GlowAttrSetFunc)(GlowValue *this, const char *attr, GlowValue *v);
 
+/* cycle collector hooks (see gc.h) */
+typedef void (*GlowVisitFunc)(GlowValue *v, void *arg);
+typedef void (*GlowTraverseFunc)(GlowValue *this, GlowVisitFunc visit, void *arg);
+
+/*
+ * Objects are reference counted with biased reference counting: the
+ * thread that allocated an object (its `owner`) counts its references
+ * in `refcnt` with plain arithmetic, while any other thread goes through
+ * the atomic `shared_refcnt`. Once an object is published to another
+ * actor (glow_share()) or its owner's count drops to zero, the two
+ * counts are merged and only `shared_refcnt` is used. See object.c.
+ */
 struct glow_object {
 	struct glow_class *class;
-	atomic_uint refcnt;
-	unsigned int monitor;
+	atomic_uint owner;
+	unsigned int refcnt;
+	atomic_int shared_refcnt;
+	unsigned short monitor;
+	unsigned short size_class;  /* see slab.h */
 };
 
+#define GLOW_OWNER_SHARED     0u
+#define GLOW_OWNER_IMMORTAL   ((unsigned int)-1)
+#define GLOW_OWNER_UNASSIGNED ((unsigned int)-2)  /* owns nothing yet */
+#define GLOW_OWNER_NONE       ((unsigned int)-3)  /* out of IDs; owns nothing */
+
+/* the owner the calling thread acts as: itself, or the task it runs (see scheduler.h) */
+extern _Thread_local unsigned int glow_current_owner;
+
 struct glow_num_methods;
 struct glow_seq_methods;
 
+/*
+ * Every resolvable class slot, roughly hottest first. Each class
+ * carries a flattened copy of these with inheritance already resolved
+ * (see glow_class_vtable()), so resolving a method is a single load.
+ */
+#define GLOW_VTABLE_SLOTS(X) \
+	X(add,      num_methods, GlowBinOp) \
+	X(sub,      num_methods, GlowBinOp) \
+	X(mul,      num_methods, GlowBinOp) \
+	X(div,      num_methods, GlowBinOp) \
+	X(mod,      num_methods, GlowBinOp) \
+	X(cmp,      direct,      GlowBinOp) \
+	X(eq,       direct,      GlowBinOp) \
+	X(hash,     direct,      GlowUnOp) \
+	X(iter,     direct,      GlowUnOp) \
+	X(iternext, direct,      GlowUnOp) \
+	X(get,      seq_methods, GlowBinOp) \
+	X(set,      seq_methods, GlowSeqSetFunc) \
+	X(len,      seq_methods, GlowUnOp) \
+	X(contains, seq_methods, GlowBinOp) \
+	X(nonzero,  num_methods, BoolUnOp) \
+	X(call,     direct,      GlowCallFunc) \
+	X(str,      direct,      GlowUnOp) \
+	X(print,    direct,      GlowPrintFunc) \
+	X(attr_get, direct,      GlowAttrGetFunc) \
+	X(attr_set, direct,      GlowAttrSetFunc) \
+	X(apply,    seq_methods, GlowBinOp) \
+	X(iapply,   seq_methods, GlowBinOp) \
+	X(plus,     num_methods, GlowUnOp) \
+	X(minus,    num_methods, GlowUnOp) \
+	X(abs,      num_methods, GlowUnOp) \
+	X(pow,      num_methods, GlowBinOp) \
+	X(bitnot,   num_methods, GlowUnOp) \
+	X(bitand,   num_methods, GlowBinOp) \
+	X(bitor,    num_methods, GlowBinOp) \
+	X(xor,      num_methods, GlowBinOp) \
+	X(shiftl,   num_methods, GlowBinOp) \
+	X(shiftr,   num_methods, GlowBinOp) \
+	X(iadd,     num_methods, GlowBinOp) \
+	X(isub,     num_methods, GlowBinOp) \
+	X(imul,     num_methods, GlowBinOp) \
+	X(idiv,     num_methods, GlowBinOp) \
+	X(imod,     num_methods, GlowBinOp) \
+	X(ipow,     num_methods, GlowBinOp) \
+	X(ibitand,  num_methods, GlowBinOp) \
+	X(ibitor,   num_methods, GlowBinOp) \
+	X(ixor,     num_methods, GlowBinOp) \
+	X(ishiftl,  num_methods, GlowBinOp) \
+	X(ishiftr,  num_methods, GlowBinOp) \
+	X(radd,     num_methods, GlowBinOp) \
+	X(rsub,     num_methods, GlowBinOp) \
+	X(rmul,     num_methods, GlowBinOp) \
+	X(rdiv,     num_methods, GlowBinOp) \
+	X(rmod,     num_methods, GlowBinOp) \
+	X(rpow,     num_methods, GlowBinOp) \
+	X(rbitand,  num_methods, GlowBinOp) \
+	X(rbitor,   num_methods, GlowBinOp) \
+	X(rxor,     num_methods, GlowBinOp) \
+	X(rshiftl,  num_methods, GlowBinOp) \
+	X(rshiftr,  num_methods, GlowBinOp) \
+	X(to_int,   num_methods, GlowUnOp) \
+	X(to_float, num_methods, GlowUnOp)
+
+#define GLOW_VTABLE_FIELD(name, category, type) type name;
+struct glow_vtable {
+	GLOW_VTABLE_SLOTS(GLOW_VTABLE_FIELD)
+};
+#undef GLOW_VTABLE_FIELD
+
 struct glow_class {
 	GlowObject base;
 	const char *name;
@@ -53,6 +145,15 @@ struct glow_class {
 	GlowInitFunc init;
 	GlowDelFunc del;  /* every class should implement this */
 
+	/*
+	 * Containers that can take part in reference cycles: `traverse`
+	 * visits every reference the object holds and `clear` drops them.
+	 * Instances of classes with `traverse` carry a GC header and should
+	 * be passed to glow_gc_track() once initialized. Not inherited.
+	 */
+	GlowTraverseFunc traverse;
+	GlowDelFunc clear;
+
 	GlowBinOp eq;
 	GlowUnOp hash;
 	GlowBinOp cmp;
@@ -69,10 +170,15 @@ struct glow_class {
 
 	struct glow_attr_member *members;
 	struct glow_attr_method *methods;
+	struct glow_attr_static *statics;  /* not inherited */
 	GlowAttrDict attr_dict;
 
 	GlowAttrGetFunc attr_get;
 	GlowAttrSetFunc attr_set;
+
+	/* vtable is valid iff vtable_epoch == glow_vtable_epoch */
+	atomic_uint vtable_epoch;
+	_Alignas(64) struct glow_vtable vtable;
 };
 
 struct glow_num_methods {
@@ -139,29 +245,33 @@ extern struct glow_num_methods obj_num_methods;
 extern struct glow_seq_methods obj_seq_methods;
 extern GlowClass glow_obj_class;
 
-#define GLOW_OBJ_INIT_STATIC(class_) { .class = (class_), .refcnt = -1 }
+#define GLOW_OBJ_INIT_STATIC(class_) { .class = (class_), .owner = GLOW_OWNER_IMMORTAL }
 #define GLOW_CLASS_BASE_INIT()       GLOW_OBJ_INIT_STATIC(&glow_meta_class)
 
 struct glow_error;
 
+enum glow_val_type {
+	/* nonexistent value */
+	GLOW_VAL_TYPE_EMPTY = 0,
+
+	/* standard type classes */
+	GLOW_VAL_TYPE_NULL,
+	GLOW_VAL_TYPE_BOOL,
+	GLOW_VAL_TYPE_INT,
+	GLOW_VAL_TYPE_FLOAT,
+	GLOW_VAL_TYPE_OBJECT,
+	GLOW_VAL_TYPE_EXC,
+
+	/* flags */
+	GLOW_VAL_TYPE_ERROR,
+	GLOW_VAL_TYPE_UNSUPPORTED_TYPES,
+	GLOW_VAL_TYPE_DIV_BY_ZERO
+};
+
+#ifndef GLOW_NAN_BOXING
+
 struct glow_value {
-	enum {
-		/* nonexistent value */
-		GLOW_VAL_TYPE_EMPTY = 0,
-
-		/* standard type classes */
-		GLOW_VAL_TYPE_NULL,
-		GLOW_VAL_TYPE_BOOL,
-		GLOW_VAL_TYPE_INT,
-		GLOW_VAL_TYPE_FLOAT,
-		GLOW_VAL_TYPE_OBJECT,
-		GLOW_VAL_TYPE_EXC,
-
-		/* flags */
-		GLOW_VAL_TYPE_ERROR,
-		GLOW_VAL_TYPE_UNSUPPORTED_TYPES,
-		GLOW_VAL_TYPE_DIV_BY_ZERO
-	} type;
+	enum glow_val_type type;
 
 	union {
 		bool b;
@@ -172,6 +282,8 @@ struct glow_value {
 	} data;
 };
 
+#define glow_valtype(val)    ((val)->type)
+
 #define glow_isempty(val)    ((val)->type == GLOW_VAL_TYPE_EMPTY)
 #define glow_isbool(val)     ((val)->type == GLOW_VAL_TYPE_BOOL)
 #define glow_isnull(val)     ((val)->type == GLOW_VAL_TYPE_NULL)
@@ -190,9 +302,7 @@ struct glow_value {
 #define glow_floatvalue(val) ((val)->data.f)
 #define glow_objvalue(val)   ((val)->data.o)
 #define glow_errvalue(val)   ((val)->data.e)
-
-#define glow_intvalue_force(val)   (glow_isint(val) ? glow_intvalue(val) : (long)glow_floatvalue(val))
-#define glow_floatvalue_force(val) (glow_isint(val) ? (double)glow_intvalue(val) : glow_floatvalue(val))
+#define glow_ptrvalue(val)   ((val)->data.o)
 
 #define glow_makeempty()     ((GlowValue){.type = GLOW_VAL_TYPE_EMPTY, .data = {.i = 0}})
 #define glow_makenull()      ((GlowValue){.type = GLOW_VAL_TYPE_NULL, .data = {.i = 0}})
@@ -201,6 +311,8 @@ struct glow_value {
 #define glow_makefalse()     ((GlowValue){.type = GLOW_VAL_TYPE_BOOL, .data = {.b = 0}})
 #define glow_makeint(val)    ((GlowValue){.type = GLOW_VAL_TYPE_INT, .data = {.i = (val)}})
 #define glow_makefloat(val)  ((GlowValue){.type = GLOW_VAL_TYPE_FLOAT, .data = {.f = (val)}})
+#define glow_makehash(val)   glow_makeint(val)
+#define glow_int_fits(val)   true
 #define glow_makeobj(val)    ((GlowValue){.type = GLOW_VAL_TYPE_OBJECT, .data = {.o = (val)}})
 #define glow_makeexc(val)    ((GlowValue){.type = GLOW_VAL_TYPE_EXC, .data = {.o = (val)}})
 
@@ -208,6 +320,9 @@ struct glow_value {
 #define glow_makeut()        ((GlowValue){.type = GLOW_VAL_TYPE_UNSUPPORTED_TYPES})
 #define glow_makedbz()       ((GlowValue){.type = GLOW_VAL_TYPE_DIV_BY_ZERO})
 
+/* opaque non-object pointer, never retained or released */
+#define glow_makeptr(val)    ((GlowValue){.type = GLOW_VAL_TYPE_EMPTY, .data = {.o = (void *)(val)}})
+
 #define GLOW_MAKE_EMPTY()     { .type = GLOW_VAL_TYPE_EMPTY, .data = { .i = 0 } }
 #define GLOW_MAKE_NULL()      { .type = GLOW_VAL_TYPE_NULL, .data = { .i = 0 } }
 #define GLOW_MAKE_BOOL(val)   { .type = GLOW_VAL_TYPE_BOOL, .data = { .b = (val) } }
@@ -222,6 +337,167 @@ struct glow_value {
 #define GLOW_MAKE_UT()        { .type = GLOW_VAL_TYPE_UNSUPPORTED_TYPES }
 #define GLOW_MAKE_DBZ()       { .type = GLOW_VAL_TYPE_DIV_BY_ZERO }
 
+#else /* GLOW_NAN_BOXING */
+
+/*
+ * NaN-boxed values: everything fits in 64 bits. Ints carry the tag
+ * 0xFFFF in their top 16 bits and a 48-bit payload; doubles are stored
+ * offset by 2^48, so their top 16 bits land in [0x0001, 0xFFFE] (NaNs
+ * are canonicalized first). A zero top half leaves a pointer, which is
+ * at least 8-byte aligned, so the low 3 bits tag everything else:
+ *
+ *   0  object pointer (all-zero bits are the empty value)
+ *   1  exception object pointer
+ *   2  error pointer
+ *   3  opaque pointer (see glow_makeptr())
+ *   4  null
+ *   5  bool, value in bit 3
+ *   6  unsupported types
+ *   7  division by zero
+ *
+ * Ints therefore only have 48 bits in this mode; glow_makeint() turns
+ * anything wider into a Float rather than dropping the high bits.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+struct glow_value {
+	union {
+		uint64_t bits;
+		void *o;
+	};
+};
+
+#define GLOW_NB_INT_TAG       0xFFFF000000000000ULL
+#define GLOW_NB_INT_MASK      0x0000FFFFFFFFFFFFULL
+#define GLOW_NB_DOUBLE_OFFSET 0x0001000000000000ULL
+#define GLOW_NB_TAG_MASK      0xFFFF000000000007ULL
+#define GLOW_NB_CANONICAL_NAN 0x7FF8000000000000ULL
+#define GLOW_NB_INT_MAX       ((long)(GLOW_NB_INT_MASK >> 1))
+#define GLOW_NB_INT_MIN       (-GLOW_NB_INT_MAX - 1)
+
+enum {
+	GLOW_NB_TAG_OBJECT = 0,
+	GLOW_NB_TAG_EXC,
+	GLOW_NB_TAG_ERROR,
+	GLOW_NB_TAG_PTR,
+	GLOW_NB_TAG_NULL,
+	GLOW_NB_TAG_BOOL,
+	GLOW_NB_TAG_UT,
+	GLOW_NB_TAG_DBZ
+};
+
+#define glow_isempty(val)    ((val)->bits == 0)
+#define glow_isbool(val)     (((val)->bits & ~(uint64_t)8) == GLOW_NB_TAG_BOOL)
+#define glow_isnull(val)     ((val)->bits == GLOW_NB_TAG_NULL)
+#define glow_isint(val)      ((val)->bits >= GLOW_NB_INT_TAG)
+#define glow_isfloat(val)    ((val)->bits - GLOW_NB_DOUBLE_OFFSET < GLOW_NB_INT_TAG - GLOW_NB_DOUBLE_OFFSET)
+#define glow_isnumber(val)   ((val)->bits >= GLOW_NB_DOUBLE_OFFSET)
+#define glow_isobject(val)   (((val)->bits & GLOW_NB_TAG_MASK) == GLOW_NB_TAG_OBJECT && !glow_isempty(val))
+#define glow_isexc(val)      (((val)->bits & GLOW_NB_TAG_MASK) == GLOW_NB_TAG_EXC)
+
+#define glow_iserror(val)    (((val)->bits & GLOW_NB_TAG_MASK) - GLOW_NB_TAG_EXC <= GLOW_NB_TAG_ERROR - GLOW_NB_TAG_EXC)
+#define glow_isut(val)       ((val)->bits == GLOW_NB_TAG_UT)
+#define glow_isdbz(val)      ((val)->bits == GLOW_NB_TAG_DBZ)
+
+static inline double glow_nb_floatvalue(const GlowValue *v)
+{
+	const uint64_t bits = v->bits - GLOW_NB_DOUBLE_OFFSET;
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+#define glow_boolvalue(val)  ((bool)(((val)->bits >> 3) & 1))
+#define glow_intvalue(val)   ((long)((int64_t)((val)->bits << 16) >> 16))
+#define glow_floatvalue(val) glow_nb_floatvalue(val)
+#define glow_objvalue(val)   ((void *)(uintptr_t)((val)->bits & ~(uint64_t)7))
+#define glow_errvalue(val)   ((struct glow_error *)glow_objvalue(val))
+#define glow_ptrvalue(val)   glow_objvalue(val)
+
+static inline GlowValue glow_makefloat(double d)
+{
+	uint64_t bits = GLOW_NB_CANONICAL_NAN;
+	if (d == d)
+		memcpy(&bits, &d, sizeof(bits));
+	return (GlowValue){.bits = bits + GLOW_NB_DOUBLE_OFFSET};
+}
+
+#define GLOW_NB_MAKE_PTR(val, tag) ((GlowValue){.bits = (uint64_t)(uintptr_t)(val) | (tag)})
+
+#define glow_makeempty()     ((GlowValue){.bits = 0})
+#define glow_makenull()      ((GlowValue){.bits = GLOW_NB_TAG_NULL})
+#define glow_makebool(val)   ((GlowValue){.bits = ((uint64_t)((val) != 0) << 3) | GLOW_NB_TAG_BOOL})
+#define glow_maketrue()      glow_makebool(1)
+#define glow_makefalse()     glow_makebool(0)
+#define glow_int_fits(val)   ((val) >= GLOW_NB_INT_MIN && (val) <= GLOW_NB_INT_MAX)
+
+/* keeps only the low 48 bits; fine for hashes, which need only be consistent */
+#define glow_makehash(val)   ((GlowValue){.bits = ((uint64_t)(long)(val) & GLOW_NB_INT_MASK) | GLOW_NB_INT_TAG})
+#define glow_makeobj(val)    GLOW_NB_MAKE_PTR(val, GLOW_NB_TAG_OBJECT)
+#define glow_makeexc(val)    GLOW_NB_MAKE_PTR(val, GLOW_NB_TAG_EXC)
+
+#define glow_makeerr(val)    GLOW_NB_MAKE_PTR(val, GLOW_NB_TAG_ERROR)
+#define glow_makeut()        ((GlowValue){.bits = GLOW_NB_TAG_UT})
+#define glow_makedbz()       ((GlowValue){.bits = GLOW_NB_TAG_DBZ})
+
+/* opaque non-object pointer, never retained or released */
+#define glow_makeptr(val)    GLOW_NB_MAKE_PTR(val, GLOW_NB_TAG_PTR)
+
+static inline GlowValue glow_makeint(const long val)
+{
+	if (glow_int_fits(val))
+		return glow_makehash(val);
+
+	return glow_makefloat((double)val);
+}
+
+static inline enum glow_val_type glow_valtype(const GlowValue *v)
+{
+	if (glow_isint(v))
+		return GLOW_VAL_TYPE_INT;
+
+	if (glow_isfloat(v))
+		return GLOW_VAL_TYPE_FLOAT;
+
+	switch (v->bits & 7) {
+	case GLOW_NB_TAG_OBJECT: return v->bits ? GLOW_VAL_TYPE_OBJECT : GLOW_VAL_TYPE_EMPTY;
+	case GLOW_NB_TAG_EXC:    return GLOW_VAL_TYPE_EXC;
+	case GLOW_NB_TAG_ERROR:  return GLOW_VAL_TYPE_ERROR;
+	case GLOW_NB_TAG_NULL:   return GLOW_VAL_TYPE_NULL;
+	case GLOW_NB_TAG_BOOL:   return GLOW_VAL_TYPE_BOOL;
+	case GLOW_NB_TAG_UT:     return GLOW_VAL_TYPE_UNSUPPORTED_TYPES;
+	case GLOW_NB_TAG_DBZ:    return GLOW_VAL_TYPE_DIV_BY_ZERO;
+	default:                 return GLOW_VAL_TYPE_EMPTY;
+	}
+}
+
+/*
+ * Static initializers. Pointer tags are added with pointer arithmetic
+ * to stay constant expressions; floats can't be reinterpreted at compile
+ * time, so they must be given as IEEE-754 bit patterns.
+ */
+#define GLOW_MAKE_EMPTY()          { .bits = 0 }
+#define GLOW_MAKE_NULL()           { .bits = GLOW_NB_TAG_NULL }
+#define GLOW_MAKE_BOOL(val)        { .bits = ((uint64_t)((val) != 0) << 3) | GLOW_NB_TAG_BOOL }
+#define GLOW_MAKE_TRUE()           GLOW_MAKE_BOOL(1)
+#define GLOW_MAKE_FALSE()          GLOW_MAKE_BOOL(0)
+/* val must fit in 48 bits */
+#define GLOW_MAKE_INT(val)         { .bits = ((uint64_t)(val) & GLOW_NB_INT_MASK) | GLOW_NB_INT_TAG }
+#define GLOW_MAKE_FLOAT_BITS(b)    { .bits = (uint64_t)(b) + GLOW_NB_DOUBLE_OFFSET }
+#define GLOW_MAKE_OBJ(val)         { .o = (val) }
+#define GLOW_MAKE_EXC(val)         { .o = (char *)(val) + GLOW_NB_TAG_EXC }
+
+#define GLOW_MAKE_ERR(val)         { .o = (char *)(val) + GLOW_NB_TAG_ERROR }
+#define GLOW_MAKE_UT()             { .bits = GLOW_NB_TAG_UT }
+#define GLOW_MAKE_DBZ()            { .bits = GLOW_NB_TAG_DBZ }
+
+#endif /* GLOW_NAN_BOXING */
+
+#define glow_intvalue_force(val)   (glow_isint(val) ? glow_intvalue(val) : (long)glow_floatvalue(val))
+#define glow_floatvalue_force(val) (glow_isint(val) ? (double)glow_intvalue(val) : glow_floatvalue(val))
+
 GlowClass *glow_getclass(GlowValue *v);
 
 bool glow_is_a(GlowValue *v, GlowClass *class);
@@ -229,67 +505,33 @@ bool glow_is_subclass(GlowClass *child, GlowClass *parent);
 
 GlowInitFunc glow_resolve_init(GlowClass *class);
 GlowDelFunc glow_resolve_del(GlowClass *class);
-GlowBinOp glow_resolve_eq(GlowClass *class);
-GlowUnOp glow_resolve_hash(GlowClass *class);
-GlowBinOp glow_resolve_cmp(GlowClass *class);
-GlowUnOp glow_resolve_str(GlowClass *class);
-GlowCallFunc glow_resolve_call(GlowClass *class);
-GlowPrintFunc glow_resolve_print(GlowClass *class);
-GlowUnOp glow_resolve_iter(GlowClass *class);
-GlowUnOp glow_resolve_iternext(GlowClass *class);
-GlowAttrGetFunc glow_resolve_attr_get(GlowClass *class);
-GlowAttrSetFunc glow_resolve_attr_set(GlowClass *class);
-
-GlowUnOp glow_resolve_plus(GlowClass *class);
-GlowUnOp glow_resolve_minus(GlowClass *class);
-GlowUnOp glow_resolve_abs(GlowClass *class);
-GlowBinOp glow_resolve_add(GlowClass *class);
-GlowBinOp glow_resolve_sub(GlowClass *class);
-GlowBinOp glow_resolve_mul(GlowClass *class);
-GlowBinOp glow_resolve_div(GlowClass *class);
-GlowBinOp glow_resolve_mod(GlowClass *class);
-GlowBinOp glow_resolve_pow(GlowClass *class);
-GlowUnOp glow_resolve_bitnot(GlowClass *class);
-GlowBinOp glow_resolve_bitand(GlowClass *class);
-GlowBinOp glow_resolve_bitor(GlowClass *class);
-GlowBinOp glow_resolve_xor(GlowClass *class);
-GlowBinOp glow_resolve_shiftl(GlowClass *class);
-GlowBinOp glow_resolve_shiftr(GlowClass *class);
-GlowBinOp glow_resolve_iadd(GlowClass *class);
-GlowBinOp glow_resolve_isub(GlowClass *class);
-GlowBinOp glow_resolve_imul(GlowClass *class);
-GlowBinOp glow_resolve_idiv(GlowClass *class);
-GlowBinOp glow_resolve_imod(GlowClass *class);
-GlowBinOp glow_resolve_ipow(GlowClass *class);
-GlowBinOp glow_resolve_ibitand(GlowClass *class);
-GlowBinOp glow_resolve_ibitor(GlowClass *class);
-GlowBinOp glow_resolve_ixor(GlowClass *class);
-GlowBinOp glow_resolve_ishiftl(GlowClass *class);
-GlowBinOp glow_resolve_ishiftr(GlowClass *class);
-GlowBinOp glow_resolve_radd(GlowClass *class);
-GlowBinOp glow_resolve_rsub(GlowClass *class);
-GlowBinOp glow_resolve_rmul(GlowClass *class);
-GlowBinOp glow_resolve_rdiv(GlowClass *class);
-GlowBinOp glow_resolve_rmod(GlowClass *class);
-GlowBinOp glow_resolve_rpow(GlowClass *class);
-GlowBinOp glow_resolve_rbitand(GlowClass *class);
-GlowBinOp glow_resolve_rbitor(GlowClass *class);
-GlowBinOp glow_resolve_rxor(GlowClass *class);
-GlowBinOp glow_resolve_rshiftl(GlowClass *class);
-GlowBinOp glow_resolve_rshiftr(GlowClass *class);
-BoolUnOp glow_resolve_nonzero(GlowClass *class);
-GlowUnOp glow_resolve_to_int(GlowClass *class);
-GlowUnOp glow_resolve_to_float(GlowClass *class);
-
-GlowUnOp glow_resolve_len(GlowClass *class);
-GlowBinOp glow_resolve_get(GlowClass *class);
-GlowSeqSetFunc glow_resolve_set(GlowClass *class);
-GlowBinOp glow_resolve_contains(GlowClass *class);
-GlowBinOp glow_resolve_apply(GlowClass *class);
-GlowBinOp glow_resolve_iapply(GlowClass *class);
+
+extern atomic_uint glow_vtable_epoch;
+
+const struct glow_vtable *glow_class_vtable_build(GlowClass *class);
+void glow_class_invalidate_vtables(void);
+
+static inline const struct glow_vtable *glow_class_vtable(GlowClass *class)
+{
+	if (atomic_load_explicit(&class->vtable_epoch, memory_order_acquire) ==
+	    atomic_load_explicit(&glow_vtable_epoch, memory_order_relaxed)) {
+		return &class->vtable;
+	}
+
+	return glow_class_vtable_build(class);
+}
+
+#define GLOW_VTABLE_RESOLVER(name, category, type) \
+static inline type glow_resolve_##name(GlowClass *class) \
+{ \
+	return glow_class_vtable(class)->name; \
+}
+GLOW_VTABLE_SLOTS(GLOW_VTABLE_RESOLVER)
+#undef GLOW_VTABLE_RESOLVER
 
 void *glow_obj_alloc(GlowClass *class);
 void *glow_obj_alloc_var(GlowClass *class, size_t extra);
+void glow_obj_dealloc(void *o);
 
 GlowValue glow_class_instantiate(GlowClass *class, GlowValue *args, size_t nargs);
 
@@ -301,6 +543,14 @@ void glow_retain(GlowValue *v);
 void glow_release(GlowValue *v);
 void glow_destroy(GlowValue *v);
 
+void glow_shareo(void *o);
+void glow_share(GlowValue *v);
+void glow_refcnt_merge_pending(void);
+void glow_refcnt_thread_exit(void);
+unsigned int glow_refcnt_owner_swap(const unsigned int owner);
+bool glow_obj_is_local(void *o);
+long glow_obj_local_refcnt(void *o);
+
 struct glow_value_array {
 	GlowValue *array;
 	size_t length;
@@ -309,13 +559,18 @@ struct glow_value_array {
 void glow_class_init(GlowClass *class);
 
 #define GLOW_SAVED_TID_FIELD_NAME _saved_id
-#define GLOW_SAVED_TID_FIELD pthread_t GLOW_SAVED_TID_FIELD_NAME;
+#define GLOW_SAVED_TID_FIELD unsigned int GLOW_SAVED_TID_FIELD_NAME;
 
+/* objects that aren't thread-safe may only be used by the owner (thread or task) that made them */
 #define GLOW_CHECK_THREAD(o) \
-	if ((o)->GLOW_SAVED_TID_FIELD_NAME != pthread_self()) \
+	if ((o)->GLOW_SAVED_TID_FIELD_NAME != glow_current_owner) \
 		return GLOW_CONC_ACCS_EXC("invalid concurrent access of non-thread-safe method or function");
 
-#define GLOW_INIT_SAVED_TID_FIELD(o) (o)->GLOW_SAVED_TID_FIELD_NAME = pthread_self()
+#define GLOW_INIT_SAVED_TID_FIELD(o) (o)->GLOW_SAVED_TID_FIELD_NAME = glow_current_owner
+
+/* true if `o` can be accessed without GLOW_ENTER (not safe'd, owned by the current owner) */
+#define GLOW_IS_LOCAL_UNGUARDED(o) \
+	(((GlowObject *)(o))->monitor == 0 && (o)->GLOW_SAVED_TID_FIELD_NAME == glow_current_owner)
 #undef GLOW_SAVED_TID_FIELD_NAME
 
 typedef struct {
@@ -0,0 +1,106 @@
+#ifndef GLOW_SCHEDULER_H
+#define GLOW_SCHEDULER_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <ucontext.h>
+
+/*
+ * M:N task scheduler. Tasks (actors) run on their own stacks,
+ * multiplexed onto a fixed pool of worker threads: one per core, or
+ * GLOW_WORKERS_ENV of them. Each worker has a work-stealing deque of
+ * tasks that have yet to run; idle workers steal from the others.
+ *
+ * Each task is an owner of objects in its own right (see object.h and
+ * gc.h): a worker acts as whichever task it is running. A task waiting
+ * on a glow_sched_cond parks, handing its worker to other tasks, and is
+ * put back on that worker's run queue when signaled; idle workers steal
+ * from run queues too, so a task may resume on any worker, and nothing
+ * thread-local may be held across a park. Tasks that run for long
+ * without parking yield now and then (see glow_sched_yield()).
+ */
+
+#define GLOW_WORKERS_ENV    "GLOW_WORKERS"
+#define GLOW_STACK_SIZE_ENV "GLOW_STACK_SIZE"  /* in KiB, like `ulimit -s` */
+
+/*
+ * Tasks' C stacks. Plain Glow-level calls don't recurse on the C stack,
+ * but generators and the printing, hashing and comparing of nested
+ * containers do, so tasks get as much as a thread would by default.
+ * Pages are only committed once used, and a guard page below each
+ * stack turns overflows into faults.
+ */
+#define GLOW_TASK_STACK_SIZE (8 * 1024 * 1024)
+
+struct glow_worker;
+struct glow_gc_state;
+
+struct glow_task {
+	void (*run)(struct glow_task *task);
+	/* called by the worker once `run` has returned; the task may be freed from then on */
+	void (*finish)(struct glow_task *task);
+
+	ucontext_t context;
+	void *stack;  /* including its guard page */
+	struct glow_worker *worker;  /* the one it last ran on; NULL until the task first runs */
+
+	/* what the task owns while it isn't running */
+	unsigned int owner;
+	struct glow_gc_state *gc;
+
+	atomic_bool parked;
+	struct glow_task *run_next;   /* in a worker's run queue */
+	struct glow_task *wait_next;  /* in a glow_sched_cond's waiters */
+
+	/* timed waits */
+	struct glow_task *timer_next;
+	struct timespec deadline;
+	atomic_bool timed;
+};
+
+void glow_sched_task_init(struct glow_task *task,
+                          void (*run)(struct glow_task *task),
+                          void (*finish)(struct glow_task *task));
+
+/* queues a task to run on the worker pool, starting the pool if need be */
+void glow_sched_spawn(struct glow_task *task);
+
+/* the task running on this thread, or NULL outside of worker threads */
+struct glow_task *glow_sched_current(void);
+
+/*
+ * Lets other queued tasks run, if there are any, by sending the current
+ * task to the back of the pool's queue; no-op outside of worker threads.
+ */
+void glow_sched_yield(void);
+
+/* stops the worker pool once its tasks have finished; it restarts on the next spawn */
+void glow_sched_shutdown(void);
+
+/*
+ * Condition variable that parks tasks rather than blocking their worker.
+ * Threads outside of the pool wait on it like on a pthread_cond_t.
+ */
+struct glow_sched_cond {
+	pthread_cond_t cond;
+	struct glow_task *waiters;
+};
+
+void glow_sched_cond_init(struct glow_sched_cond *cond);
+void glow_sched_cond_destroy(struct glow_sched_cond *cond);
+
+/* `mutex` must be held, and is held again on return */
+void glow_sched_cond_wait(struct glow_sched_cond *cond, pthread_mutex_t *mutex);
+
+/* returns false if `deadline` (TIME_UTC) passed first */
+bool glow_sched_cond_timedwait(struct glow_sched_cond *cond,
+                               pthread_mutex_t *mutex,
+                               const struct timespec *deadline);
+
+/* `mutex` must be held */
+void glow_sched_cond_broadcast(struct glow_sched_cond *cond);
+
+#endif /* GLOW_SCHEDULER_H */
@@ -8,18 +8,24 @@ extern struct glow_num_methods glow_set_num_methods;
 extern struct glow_seq_methods glow_set_seq_methods;
 extern GlowClass glow_set_class;
 
+/* slots per probe group; the capacity is always a multiple of this */
+#define GLOW_SET_GROUP_WIDTH 16
+
 struct glow_set_entry {
 	GlowValue element;
 	int hash;
-	struct glow_set_entry *next;
 };
 
 typedef struct {
 	GlowObject base;
-	struct glow_set_entry **entries;
+
+	/* one control byte per slot, followed by the slots themselves */
+	signed char *ctrl;
+	struct glow_set_entry *slots;
+
 	size_t count;
 	size_t capacity;
-	size_t threshold;
+	size_t growth_left;  /* # insertions into empty slots before a resize */
 	unsigned state_id;
 	GLOW_SAVED_TID_FIELD
 } GlowSetObject;
@@ -30,6 +36,9 @@ GlowValue glow_set_remove(GlowSetObject *set, GlowValue *element);
 GlowValue glow_set_contains(GlowSetObject *set, GlowValue *element);
 GlowValue glow_set_eq(GlowSetObject *set, GlowSetObject *other);
 size_t glow_set_len(GlowSetObject *set);
+GlowValue glow_set_union(GlowSetObject *set, GlowSetObject *other);
+GlowValue glow_set_intersection(GlowSetObject *set, GlowSetObject *other);
+GlowValue glow_set_difference(GlowSetObject *set, GlowSetObject *other);
 
 extern GlowClass glow_set_iter_class;
 
@@ -38,7 +47,6 @@ typedef struct {
 	GlowSetObject *source;
 	unsigned saved_state_id;
 	size_t current_index;
-	struct glow_set_entry *current_entry;
 } GlowSetIter;
 
 #endif /* GLOW_SET_H */
@@ -0,0 +1,33 @@
+#ifndef GLOW_SLAB_H
+#define GLOW_SLAB_H
+
+#include <stdlib.h>
+
+/*
+ * Thread-local size-class allocator backing glow_obj_alloc(). Blocks of
+ * up to GLOW_SLAB_MAX_SIZE bytes are carved out of pages owned by the
+ * allocating thread and recycled through per-size-class free lists;
+ * larger requests go straight to malloc. Any thread may free a block:
+ * blocks freed away from their page's thread are handed back to it.
+ *
+ * Define GLOW_NO_SLAB to route every object through malloc instead
+ * (e.g. for memory checkers).
+ */
+
+#define GLOW_SLAB_GRANULE     8
+#define GLOW_SLAB_MAX_SIZE    512
+#define GLOW_SLAB_NUM_CLASSES (GLOW_SLAB_MAX_SIZE / GLOW_SLAB_GRANULE)
+
+/* size class (1..GLOW_SLAB_NUM_CLASSES) of an n-byte block, or 0 if malloc'd */
+#ifndef GLOW_NO_SLAB
+#define glow_slab_size_class(n) \
+	((n) <= GLOW_SLAB_MAX_SIZE ? ((n) + GLOW_SLAB_GRANULE - 1) / GLOW_SLAB_GRANULE : 0)
+#else
+#define glow_slab_size_class(n) 0
+#endif
+
+void *glow_slab_alloc(unsigned int size_class);
+void glow_slab_free(void *p);
+void glow_slab_thread_exit(void);
+
+#endif /* GLOW_SLAB_H */
@@ -11,9 +11,10 @@ typedef struct {
 	int hash;
 	unsigned hashed : 1;
 	unsigned freeable : 1;
+	unsigned interned : 1;  /* see glow_str_intern() */
 } GlowStr;
 
-#define GLOW_STR_INIT(v, l, f) ((GlowStr){.value = (v), .len = (l), .hash = 0, .hashed = 0, .freeable = (f)})
+#define GLOW_STR_INIT(v, l, f) ((GlowStr){.value = (v), .len = (l), .hash = 0, .hashed = 0, .freeable = (f), .interned = 0})
 
 GlowStr *glow_str_new(const char *value, const size_t len);
 GlowStr *glow_str_new_copy(const char *value, const size_t len);
@@ -24,6 +25,13 @@ int glow_str_hash(GlowStr *str);
 
 GlowStr *glow_str_cat(GlowStr *s1, GlowStr *s2);
 
+/*
+ * Returns the canonical copy of the given string, which lives as long as
+ * the process and has its hash precomputed. Two interned strings are
+ * equal exactly when their `value` pointers are. Thread-safe.
+ */
+const GlowStr *glow_str_intern(const char *value, const size_t len);
+
 void glow_str_dealloc(GlowStr *str);
 void glow_str_free(GlowStr *str);
 
@@ -5,21 +5,26 @@
 #include "str.h"
 #include "object.h"
 
+/*
+ * Flat open-addressing string dictionary. Keys are interned (see
+ * glow_str_intern()), so an interned probe key is matched by pointer
+ * and never needs its characters compared or its hash recomputed.
+ */
+
 typedef struct str_dict_entry {
-	GlowStr key;
-	int hash;
+	GlowStr key;  /* interned; `key.value` is NULL if the slot is empty */
 	GlowValue value;
-	struct str_dict_entry *next;
 } GlowStrDictEntry;
 
 typedef struct {
-	GlowStrDictEntry **table;
+	GlowStrDictEntry *table;
 	size_t count;
 	size_t capacity;
-	size_t threshold;
 } GlowStrDict;
 
 void glow_strdict_init(GlowStrDict *dict);
+
+/* `key` caches its hash, so repeated lookups with the same GlowStr are a single probe */
 GlowValue glow_strdict_get(GlowStrDict *dict, GlowStr *key);
 GlowValue glow_strdict_get_cstr(GlowStrDict *dict, const char *key);
 void glow_strdict_put(GlowStrDict *dict, const char *key, GlowValue *value, bool key_freeable);
@@ -19,4 +19,7 @@ typedef struct glow_str_object {
 GlowValue glow_strobj_make(GlowStr value);
 GlowValue glow_strobj_make_direct(const char *value, const size_t len);
 
+/* backed by the interned copy of `value`, so it compares by pointer with other interned strings */
+GlowValue glow_strobj_make_interned(const char *value, const size_t len);
+
 #endif /* GLOW_STROBJECT_H */
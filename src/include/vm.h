@@ -12,20 +12,6 @@
 #include "module.h"
 #include "main.h"
 
-struct glow_exc_stack_element {
-	size_t start;  /* start position of try-block */
-	size_t end;    /* end position of try-block */
-	size_t handler_pos;  /* where to jump in case of exception */
-
-	/*
-	 * Some opcodes could be using space on the stack
-	 * long-term, so if we catch an exception, we don't
-	 * want to clear the whole stack. This pointer
-	 * defines where we should stop clearing.
-	 */
-	GlowValue *purge_wall;
-};
-
 struct glow_mailbox;
 
 typedef struct glow_frame {
@@ -34,24 +20,20 @@ typedef struct glow_frame {
 	GlowValue *locals;
 	size_t n_locals;
 
-	GlowStr *frees;  /* free variables */
 	GlowValue *val_stack;
 	GlowValue *val_stack_base;
 	GlowValue return_value;
 
-	struct glow_exc_stack_element *exc_stack_base;
-	struct glow_exc_stack_element *exc_stack;
-
 	size_t pos;  /* position in bytecode */
 	struct glow_frame *prev;
 
 	struct glow_mailbox *mailbox;  /* support for actors */
-	atomic_flag owned;
 
 	unsigned active            : 1;
 	unsigned persistent        : 1;
 	unsigned top_level         : 1;
 	unsigned force_free_locals : 1;
+	unsigned inline_call       : 1;  /* run by the caller's eval loop */
 } GlowFrame;
 
 typedef struct glow_vm {
@@ -84,14 +66,17 @@ GlowFrame *glow_frame_make(GlowCodeObject *co);
 void glow_frame_save_state(GlowFrame *frame,
                           const size_t pos,
                           GlowValue ret_val,
-                          GlowValue *val_stack,
-                          struct glow_exc_stack_element *exc_stack);
+                          GlowValue *val_stack);
 void glow_frame_reset(GlowFrame *frame);
 void glow_frame_free(GlowFrame *frame);
+void glow_frame_pool_free(GlowCodeObject *co);
 
 GlowVM *glow_current_vm_get(void);
 void glow_current_vm_set(GlowVM *vm);
 
 void glow_vm_register_module(const GlowModule *module);
 
+/* the builtin named `name`, or an empty value; builtins never change once loaded */
+GlowValue glow_vm_get_builtin(GlowStr *name);
+
 #endif /* GLOW_VM_H */
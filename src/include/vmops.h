@@ -90,10 +90,14 @@ GlowValue glow_op_get_attr(GlowValue *v, const char *attr);
 
 GlowValue glow_op_get_attr_default(GlowValue *v, const char *attr);
 
+GlowValue glow_op_get_attr_resolved(GlowValue *v, GlowClass *class, const unsigned int value, const char *attr);
+
 GlowValue glow_op_set_attr(GlowValue *v, const char *attr, GlowValue *new);
 
 GlowValue glow_op_set_attr_default(GlowValue *v, const char *attr, GlowValue *new);
 
+GlowValue glow_op_set_attr_resolved(GlowValue *v, GlowClass *v_class, const unsigned int value, const char *attr, GlowValue *new);
+
 GlowValue glow_op_call(GlowValue *v,
                  GlowValue *args,
                  GlowValue *args_named,
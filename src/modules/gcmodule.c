@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include "object.h"
+#include "strobject.h"
+#include "tupleobject.h"
+#include "iter.h"
+#include "dictobject.h"
+#include "util.h"
+#include "nativefunc.h"
+#include "exc.h"
+#include "module.h"
+#include "builtins.h"
+#include "strdict.h"
+#include "gc.h"
+#include "gcmodule.h"
+
+static GlowValue gc_collect(GlowValue *args, size_t nargs)
+{
+#define NAME "collect"
+	GLOW_ARG_COUNT_CHECK_AT_MOST(NAME, nargs, 1);
+	long gen = GLOW_GC_GENERATIONS - 1;
+
+	if (nargs == 1) {
+		if (!glow_isint(&args[0])) {
+			return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[0]));
+		}
+
+		gen = glow_intvalue(&args[0]);
+
+		if (gen < 0 || gen >= GLOW_GC_GENERATIONS) {
+			return GLOW_INDEX_EXC(NAME "(): generation out of range (generation = %li)", gen);
+		}
+	}
+
+	return glow_makeint((long)glow_gc_collect((unsigned int)gen));
+#undef NAME
+}
+
+static GlowValue gc_set_threshold(GlowValue *args, size_t nargs)
+{
+#define NAME "set_threshold"
+	GLOW_ARG_COUNT_CHECK_BETWEEN(NAME, nargs, 1, GLOW_GC_GENERATIONS);
+
+	for (size_t i = 0; i < nargs; i++) {
+		if (!glow_isint(&args[i])) {
+			return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[i]));
+		}
+
+		if (glow_intvalue(&args[i]) < 0) {
+			return GLOW_TYPE_EXC(NAME "(): thresholds cannot be negative");
+		}
+	}
+
+	for (size_t i = 0; i < nargs; i++) {
+		glow_gc_set_threshold(i, (unsigned int)glow_intvalue(&args[i]));
+	}
+
+	return glow_makenull();
+#undef NAME
+}
+
+static GlowValue gc_get_threshold(GlowValue *args, size_t nargs)
+{
+#define NAME "get_threshold"
+	GLOW_UNUSED(args);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 0);
+	GlowValue thresholds[GLOW_GC_GENERATIONS];
+
+	for (size_t i = 0; i < GLOW_GC_GENERATIONS; i++) {
+		thresholds[i] = glow_makeint((long)glow_gc_get_threshold(i));
+	}
+
+	return glow_tuple_make(thresholds, GLOW_GC_GENERATIONS);
+#undef NAME
+}
+
+static GlowValue gc_stats(GlowValue *args, size_t nargs)
+{
+#define NAME "stats"
+	GLOW_UNUSED(args);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 0);
+	struct glow_gc_stats stats;
+	glow_gc_get_stats(&stats);
+
+	GlowValue collections[GLOW_GC_GENERATIONS];
+	for (size_t i = 0; i < GLOW_GC_GENERATIONS; i++) {
+		collections[i] = glow_makeint((long)stats.collections[i]);
+	}
+
+	GlowValue entries[] = {
+		glow_strobj_make_interned("collections", 11), glow_tuple_make(collections, GLOW_GC_GENERATIONS),
+		glow_strobj_make_interned("collected", 9),    glow_makeint((long)stats.collected),
+		glow_strobj_make_interned("last_pause", 10),  glow_makefloat(stats.last_pause),
+		glow_strobj_make_interned("max_pause", 9),    glow_makefloat(stats.max_pause),
+		glow_strobj_make_interned("total_pause", 11), glow_makefloat(stats.total_pause),
+	};
+
+	return glow_dict_make(entries, sizeof(entries) / sizeof(entries[0]));
+#undef NAME
+}
+
+static GlowNativeFuncObject collect_nfo = GLOW_NFUNC_INIT(gc_collect);
+static GlowNativeFuncObject set_threshold_nfo = GLOW_NFUNC_INIT(gc_set_threshold);
+static GlowNativeFuncObject get_threshold_nfo = GLOW_NFUNC_INIT(gc_get_threshold);
+static GlowNativeFuncObject stats_nfo = GLOW_NFUNC_INIT(gc_stats);
+
+const struct glow_builtin gc_builtins[] = {
+		{"collect",       GLOW_MAKE_OBJ(&collect_nfo)},
+		{"set_threshold", GLOW_MAKE_OBJ(&set_threshold_nfo)},
+		{"get_threshold", GLOW_MAKE_OBJ(&get_threshold_nfo)},
+		{"stats",         GLOW_MAKE_OBJ(&stats_nfo)},
+		{NULL,            GLOW_MAKE_EMPTY()},
+};
+
+GlowBuiltInModule glow_gc_module = GLOW_BUILTIN_MODULE_INIT_STATIC("gc", &gc_builtins[0]);
@@ -0,0 +1,7 @@
+#ifndef GLOW_GCMODULE_H
+#define GLOW_GCMODULE_H
+
+#include "module.h"
+extern GlowBuiltInModule glow_gc_module;
+
+#endif /* GLOW_GCMODULE_H */
@@ -38,9 +38,18 @@ static GlowNativeFuncObject sin_nfo = GLOW_NFUNC_INIT(glow_sin);
 #define PI 3.14159265358979323846
 #define E  2.71828182845904523536
 
+#ifdef GLOW_NAN_BOXING
+/* bit patterns of PI and E; see GLOW_MAKE_FLOAT_BITS() */
+#define PI_VALUE GLOW_MAKE_FLOAT_BITS(0x400921FB54442D18)
+#define E_VALUE  GLOW_MAKE_FLOAT_BITS(0x4005BF0A8B145769)
+#else
+#define PI_VALUE GLOW_MAKE_FLOAT(PI)
+#define E_VALUE  GLOW_MAKE_FLOAT(E)
+#endif
+
 const struct glow_builtin math_builtins[] = {
-		{"pi",  GLOW_MAKE_FLOAT(PI)},
-		{"e",   GLOW_MAKE_FLOAT(E)},
+		{"pi",  PI_VALUE},
+		{"e",   E_VALUE},
 		{"cos", GLOW_MAKE_OBJ(&cos_nfo)},
 		{"sin", GLOW_MAKE_OBJ(&sin_nfo)},
 		{NULL,  GLOW_MAKE_EMPTY()},
@@ -100,9 +100,11 @@ static GlowValue safe(GlowValue *args, size_t nargs)
 /* Built-in modules */
 #include "iomodule.h"
 #include "mathmodule.h"
+#include "gcmodule.h"
 
 const GlowModule *glow_builtin_modules[] = {
 		(GlowModule *)&glow_io_module,
 		(GlowModule *)&glow_math_module,
+		(GlowModule *)&glow_gc_module,
 		NULL
 };
@@ -0,0 +1,402 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "object.h"
+#include "err.h"
+#include "util.h"
+#include "gc.h"
+
+/*
+ * Collection follows the classic trial deletion scheme: every candidate
+ * starts with its reference count in `refs`, from which the references
+ * held by other candidates are subtracted. Candidates left with positive
+ * `refs` are referenced from outside and keep everything they reach
+ * alive; the rest are garbage, and are freed by clearing them.
+ *
+ * Outside of a collection `refs` is GLOW_GC_REFS_IDLE, which also keeps
+ * objects of older generations out of the one being collected.
+ */
+#define GC_REFS_UNREACHABLE (-2)
+
+struct gc_generation {
+	struct glow_gc_head head;  /* list sentinel */
+	unsigned int count;
+};
+
+/* what one owner (a thread, or a task) tracks */
+struct glow_gc_state {
+	struct gc_generation generations[GLOW_GC_GENERATIONS];
+	bool initialized;
+	bool collecting;
+	bool exited;
+};
+
+static _Thread_local struct glow_gc_state thread_state;
+static _Thread_local struct glow_gc_state *current_state = NULL;  /* NULL for `thread_state` */
+
+static inline struct glow_gc_state *gc_state(void)
+{
+	struct glow_gc_state *gc = current_state;
+	return (gc != NULL) ? gc : &thread_state;
+}
+
+/*
+ * Generation 0 is collected once its allocations exceed its threshold;
+ * an older generation once the next younger one has been collected that
+ * many times.
+ */
+static atomic_uint thresholds[GLOW_GC_GENERATIONS] = {700, 10, 10};
+
+static struct glow_gc_stats stats;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define OBJ_OF(h) ((GlowObject *)((h) + 1))
+
+static inline void list_init(struct glow_gc_head *list)
+{
+	list->prev = list->next = list;
+}
+
+static inline bool list_empty(struct glow_gc_head *list)
+{
+	return list->next == list;
+}
+
+static inline void list_remove(struct glow_gc_head *h)
+{
+	h->prev->next = h->next;
+	h->next->prev = h->prev;
+}
+
+static inline void list_append(struct glow_gc_head *h, struct glow_gc_head *list)
+{
+	h->prev = list->prev;
+	h->next = list;
+	list->prev->next = h;
+	list->prev = h;
+}
+
+static inline void list_move(struct glow_gc_head *h, struct glow_gc_head *list)
+{
+	list_remove(h);
+	list_append(h, list);
+}
+
+/* appends all of `from` to `to`, leaving `from` empty */
+static void list_merge(struct glow_gc_head *from, struct glow_gc_head *to)
+{
+	if (list_empty(from)) {
+		return;
+	}
+
+	from->next->prev = to->prev;
+	to->prev->next = from->next;
+	from->prev->next = to;
+	to->prev = from->prev;
+	list_init(from);
+}
+
+static void gc_init(struct glow_gc_state *gc)
+{
+	for (size_t i = 0; i < GLOW_GC_GENERATIONS; i++) {
+		list_init(&gc->generations[i].head);
+		gc->generations[i].count = 0;
+	}
+	gc->initialized = true;
+}
+
+static inline struct glow_gc_head *value_head(GlowValue *v)
+{
+	if (!glow_isobject(v)) {
+		return NULL;
+	}
+
+	GlowObject *o = glow_objvalue(v);
+	return (o->class->traverse != NULL) ? GLOW_GC_HEAD(o) : NULL;
+}
+
+static inline void traverse(struct glow_gc_head *h, GlowVisitFunc visit, void *arg)
+{
+	GlowObject *o = OBJ_OF(h);
+	o->class->traverse(&glow_makeobj(o), visit, arg);
+}
+
+static void visit_decref(GlowValue *v, void *arg)
+{
+	GLOW_UNUSED(arg);
+	struct glow_gc_head *h = value_head(v);
+
+	if (h != NULL && h->refs > 0) {
+		--h->refs;
+	}
+}
+
+static void visit_reachable(GlowValue *v, void *arg)
+{
+	struct glow_gc_head *young = arg;
+	struct glow_gc_head *h = value_head(v);
+
+	if (h == NULL) {
+		return;
+	}
+
+	if (h->refs == 0) {
+		/* not scanned yet; will be once move_unreachable() gets to it */
+		h->refs = 1;
+	} else if (h->refs == GC_REFS_UNREACHABLE) {
+		list_move(h, young);
+		h->refs = 1;
+	}
+}
+
+/* moves the objects of `young` not reachable from outside to `unreachable` */
+static void move_unreachable(struct glow_gc_head *young, struct glow_gc_head *unreachable)
+{
+	struct glow_gc_head *h = young->next;
+
+	while (h != young) {
+		struct glow_gc_head *next;
+
+		if (h->refs != 0) {
+			traverse(h, visit_reachable, young);
+			next = h->next;
+		} else {
+			next = h->next;
+			list_move(h, unreachable);
+			h->refs = GC_REFS_UNREACHABLE;
+		}
+
+		h = next;
+	}
+}
+
+static size_t delete_garbage(struct glow_gc_head *unreachable, struct glow_gc_head *old, const unsigned int old_gen)
+{
+	size_t n = 0;
+
+	/* hold every object so none is freed before all are cleared */
+	for (struct glow_gc_head *h = unreachable->next; h != unreachable; h = h->next) {
+		h->refs = GLOW_GC_REFS_IDLE;
+		glow_retaino(OBJ_OF(h));
+		++n;
+	}
+
+	for (struct glow_gc_head *h = unreachable->next; h != unreachable; h = h->next) {
+		GlowObject *o = OBJ_OF(h);
+		o->class->clear(&glow_makeobj(o));
+	}
+
+	/* anything surviving its release stays tracked */
+	while (!list_empty(unreachable)) {
+		struct glow_gc_head *h = unreachable->next;
+		list_move(h, old);
+		h->generation = old_gen;
+		glow_releaseo(OBJ_OF(h));
+	}
+
+	return n;
+}
+
+static double elapsed(const struct timespec *start)
+{
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	return (double)(end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static size_t collect(struct glow_gc_state *gc, const unsigned int gen)
+{
+	struct gc_generation *generations = gc->generations;
+	struct timespec start;
+	timespec_get(&start, TIME_UTC);
+	gc->collecting = true;
+
+	for (unsigned int i = 0; i < gen; i++) {
+		list_merge(&generations[i].head, &generations[gen].head);
+		generations[i].count = 0;
+	}
+
+	generations[gen].count = 0;
+	if (gen + 1 < GLOW_GC_GENERATIONS) {
+		++generations[gen + 1].count;
+	}
+
+	const unsigned int old_gen = (gen + 1 < GLOW_GC_GENERATIONS) ? gen + 1 : gen;
+	struct glow_gc_head *young = &generations[gen].head;
+	struct glow_gc_head *old = &generations[old_gen].head;
+	struct glow_gc_head unreachable;
+	list_init(&unreachable);
+
+	for (struct glow_gc_head *h = young->next; h != young; h = h->next) {
+		h->refs = glow_obj_local_refcnt(OBJ_OF(h));
+	}
+
+	for (struct glow_gc_head *h = young->next; h != young; h = h->next) {
+		traverse(h, visit_decref, NULL);
+	}
+
+	move_unreachable(young, &unreachable);
+
+	for (struct glow_gc_head *h = young->next; h != young; h = h->next) {
+		h->refs = GLOW_GC_REFS_IDLE;
+		h->generation = old_gen;
+	}
+
+	if (old != young) {
+		list_merge(young, old);
+	}
+
+	const size_t n = delete_garbage(&unreachable, old, old_gen);
+	gc->collecting = false;
+
+	const double pause = elapsed(&start);
+	GLOW_SAFE(pthread_mutex_lock(&stats_mutex));
+	++stats.collections[gen];
+	stats.collected += n;
+	stats.last_pause = pause;
+	stats.total_pause += pause;
+	if (pause > stats.max_pause) {
+		stats.max_pause = pause;
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&stats_mutex));
+
+	return n;
+}
+
+/* collects the oldest generation that has exceeded its threshold */
+static void collect_generations(struct glow_gc_state *gc)
+{
+	for (unsigned int i = GLOW_GC_GENERATIONS; i-- > 0;) {
+		const unsigned int threshold = atomic_load_explicit(&thresholds[i], memory_order_relaxed);
+
+		if (gc->generations[i].count > threshold) {
+			collect(gc, i);
+			break;
+		}
+	}
+}
+
+void glow_gc_track(void *o)
+{
+	struct glow_gc_state *gc = gc_state();
+
+	/* objects of other owners (or of none) are never collected */
+	if (!glow_obj_is_local(o) || gc->exited) {
+		return;
+	}
+
+	if (!gc->initialized) {
+		gc_init(gc);
+	}
+
+	struct glow_gc_head *h = GLOW_GC_HEAD(o);
+	h->refs = GLOW_GC_REFS_IDLE;
+	h->generation = 0;
+	list_append(h, &gc->generations[0].head);
+
+	const unsigned int threshold = atomic_load_explicit(&thresholds[0], memory_order_relaxed);
+	if (++gc->generations[0].count > threshold && threshold > 0 && !gc->collecting) {
+		collect_generations(gc);
+	}
+}
+
+void glow_gc_untrack(void *o)
+{
+	struct glow_gc_head *h = GLOW_GC_HEAD(o);
+
+	if (h->next == NULL) {
+		return;
+	}
+
+	struct gc_generation *young = &gc_state()->generations[0];
+
+	/* older generations count collections rather than objects */
+	if (h->generation == 0 && young->count > 0) {
+		--young->count;
+	}
+
+	list_remove(h);
+	glow_gc_head_init(h);
+}
+
+size_t glow_gc_collect(unsigned int generation)
+{
+	struct glow_gc_state *gc = gc_state();
+
+	if (!gc->initialized || gc->collecting) {
+		return 0;
+	}
+
+	if (generation >= GLOW_GC_GENERATIONS) {
+		generation = GLOW_GC_GENERATIONS - 1;
+	}
+
+	return collect(gc, generation);
+}
+
+void glow_gc_set_threshold(unsigned int generation, unsigned int threshold)
+{
+	if (generation < GLOW_GC_GENERATIONS) {
+		atomic_store_explicit(&thresholds[generation], threshold, memory_order_relaxed);
+	}
+}
+
+unsigned int glow_gc_get_threshold(unsigned int generation)
+{
+	if (generation < GLOW_GC_GENERATIONS) {
+		return atomic_load_explicit(&thresholds[generation], memory_order_relaxed);
+	}
+	return 0;
+}
+
+void glow_gc_get_stats(struct glow_gc_stats *out)
+{
+	GLOW_SAFE(pthread_mutex_lock(&stats_mutex));
+	*out = stats;
+	GLOW_SAFE(pthread_mutex_unlock(&stats_mutex));
+}
+
+/*
+ * Untracks everything this thread (or task) still tracks; those objects
+ * are then left to reference counting, as its lists are about to vanish.
+ */
+void glow_gc_thread_exit(void)
+{
+	struct glow_gc_state *gc = gc_state();
+
+	if (!gc->initialized) {
+		return;
+	}
+
+	for (size_t i = 0; i < GLOW_GC_GENERATIONS; i++) {
+		struct glow_gc_head *list = &gc->generations[i].head;
+
+		while (!list_empty(list)) {
+			struct glow_gc_head *h = list->next;
+			list_remove(h);
+			glow_gc_head_init(h);
+		}
+	}
+
+	gc->initialized = false;
+	gc->exited = true;
+}
+
+struct glow_gc_state *glow_gc_state_new(void)
+{
+	return glow_calloc(1, sizeof(struct glow_gc_state));
+}
+
+void glow_gc_state_free(struct glow_gc_state *gc)
+{
+	free(gc);
+}
+
+struct glow_gc_state *glow_gc_state_swap(struct glow_gc_state *gc)
+{
+	struct glow_gc_state *prev = current_state;
+	current_state = gc;
+	return prev;
+}
@@ -66,8 +66,6 @@ typedef enum {
 	GLOW_INS_RETURN,
 	GLOW_INS_THROW,
 	GLOW_INS_PRODUCE,
-	GLOW_INS_TRY_BEGIN,
-	GLOW_INS_TRY_END,
 	GLOW_INS_JMP_IF_EXC_MISMATCH,
 	GLOW_INS_MAKE_LIST,
 	GLOW_INS_MAKE_TUPLE,
@@ -88,7 +86,53 @@ typedef enum {
 	GLOW_INS_DUP,
 	GLOW_INS_DUP_TWO,
 	GLOW_INS_ROT,
-	GLOW_INS_ROT_THREE
+	GLOW_INS_ROT_THREE,
+	GLOW_INS_LOAD_METHOD,
+	GLOW_INS_CALL_METHOD,
+
+	/*
+	 * Intrinsics: single-argument calls to builtins, emitted in place
+	 * of LOAD_NAME + CALL (`iter(x)` compiles to GET_ITER).
+	 */
+	GLOW_INS_LEN,
+	GLOW_INS_HASH,
+	GLOW_INS_STR,
+	GLOW_INS_TYPE,
+	GLOW_INS_NEXT,
+
+	/*
+	 * Integer range loops: `for i in a..b` keeps the counter and
+	 * its end on the stack instead of building a range iterator.
+	 */
+	GLOW_INS_SETUP_RANGE,
+	GLOW_INS_FOR_RANGE,
+
+	/* `receive x, n`: takes up to n queued messages as a list */
+	GLOW_INS_RECEIVE_BATCH,
+
+	/*
+	 * Specialized instructions. These are never emitted by the
+	 * compiler; the VM rewrites generic instructions into them
+	 * in place once it has observed the operand types.
+	 */
+	GLOW_INS_ADD_INT_INT,
+	GLOW_INS_SUB_INT_INT,
+	GLOW_INS_MUL_INT_INT,
+	GLOW_INS_MOD_INT_INT,
+	GLOW_INS_EQUAL_INT_INT,
+	GLOW_INS_NOTEQ_INT_INT,
+	GLOW_INS_LT_INT_INT,
+	GLOW_INS_GT_INT_INT,
+	GLOW_INS_LE_INT_INT,
+	GLOW_INS_GE_INT_INT,
+	GLOW_INS_ADD_FLOAT_FLOAT,
+	GLOW_INS_SUB_FLOAT_FLOAT,
+	GLOW_INS_MUL_FLOAT_FLOAT,
+	GLOW_INS_DIV_FLOAT_FLOAT,
+	GLOW_INS_LT_FLOAT_FLOAT,
+	GLOW_INS_GT_FLOAT_FLOAT,
+	GLOW_INS_LE_FLOAT_FLOAT,
+	GLOW_INS_GE_FLOAT_FLOAT
 } GlowOpcode;
 
 typedef enum {
@@ -0,0 +1,807 @@
+#define _DEFAULT_SOURCE  /* MAP_ANONYMOUS, MAP_NORESERVE */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "err.h"
+#include "util.h"
+#include "object.h"
+#include "gc.h"
+#include "slab.h"
+#include "vm.h"
+#include "scheduler.h"
+
+/*
+ * Work-stealing deque (Chase and Lev; C11 formulation by Lê et al.).
+ * The owning worker pushes and takes at the bottom, thieves steal from
+ * the top. Grown arrays are kept until the deque is freed, as thieves
+ * may still be reading them.
+ */
+#define DEQUE_INIT_CAPACITY 64
+
+struct deque_array {
+	long capacity;  /* a power of 2 */
+	struct deque_array *prev;
+	_Atomic(struct glow_task *) tasks[];
+};
+
+struct deque {
+	atomic_long top;
+	atomic_long bottom;
+	_Atomic(struct deque_array *) array;
+};
+
+/* stacks each worker keeps around for its next tasks */
+#define STACK_CACHE_SIZE 16
+
+struct glow_worker {
+	pthread_t thread;
+	unsigned int index;
+
+	ucontext_t context;  /* the scheduling loop */
+	struct glow_task *current;
+
+	/* what to do once `current` has switched back to the scheduling loop */
+	bool task_done;
+	bool task_yielded;
+	pthread_mutex_t *task_parked_on;
+
+	struct deque deque;
+
+	/* resumed tasks, pushed by any thread and taken by any worker */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct glow_task *run_head;
+	struct glow_task *run_tail;
+	atomic_uint n_run;  /* for thieves and yielding tasks to peek at */
+	bool sleeping;
+
+	/* tasks that parked here in timed waits, by deadline; guarded by `mutex` */
+	struct glow_task *timers;
+	atomic_uint n_timers;  /* for peeking at */
+
+	void *stacks[STACK_CACHE_SIZE];
+	unsigned int n_stacks;
+};
+
+static struct glow_worker *workers = NULL;
+static unsigned int n_workers = 0;
+static size_t stack_size = 0;  /* excluding the guard page */
+static size_t page_size = 0;
+static atomic_bool stopping = false;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* tasks spawned from outside of the pool */
+static struct glow_task *inject_head = NULL;
+static struct glow_task *inject_tail = NULL;
+static pthread_mutex_t inject_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* tasks waiting in deques or the injection queue, and workers asleep */
+static atomic_long n_queued = 0;
+static atomic_uint n_sleeping = 0;
+
+static _Thread_local struct glow_worker *current_worker = NULL;
+
+static struct deque_array *deque_array_new(const long capacity)
+{
+	struct deque_array *a = glow_malloc(sizeof(struct deque_array) + capacity * sizeof(a->tasks[0]));
+	a->capacity = capacity;
+	a->prev = NULL;
+	return a;
+}
+
+static void deque_init(struct deque *dq)
+{
+	atomic_init(&dq->top, 0);
+	atomic_init(&dq->bottom, 0);
+	atomic_init(&dq->array, deque_array_new(DEQUE_INIT_CAPACITY));
+}
+
+static void deque_dealloc(struct deque *dq)
+{
+	struct deque_array *a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+	while (a != NULL) {
+		struct deque_array *prev = a->prev;
+		free(a);
+		a = prev;
+	}
+}
+
+static struct deque_array *deque_grow(struct deque *dq, struct deque_array *old, const long t, const long b)
+{
+	struct deque_array *a = deque_array_new(old->capacity * 2);
+
+	for (long i = t; i < b; i++) {
+		struct glow_task *task = atomic_load_explicit(&old->tasks[i & (old->capacity - 1)], memory_order_relaxed);
+		atomic_store_explicit(&a->tasks[i & (a->capacity - 1)], task, memory_order_relaxed);
+	}
+
+	a->prev = old;
+	atomic_store_explicit(&dq->array, a, memory_order_release);
+	return a;
+}
+
+static void deque_push(struct deque *dq, struct glow_task *task)
+{
+	const long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+	const long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+	struct deque_array *a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+
+	if (b - t > a->capacity - 1) {
+		a = deque_grow(dq, a, t, b);
+	}
+
+	atomic_store_explicit(&a->tasks[b & (a->capacity - 1)], task, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+}
+
+static struct glow_task *deque_take(struct deque *dq)
+{
+	const long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+	struct deque_array *a = atomic_load_explicit(&dq->array, memory_order_relaxed);
+	atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+	if (t > b) {
+		atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	struct glow_task *task = atomic_load_explicit(&a->tasks[b & (a->capacity - 1)], memory_order_relaxed);
+
+	if (t == b) {
+		/* last task: race the thieves for it */
+		if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+		                                             memory_order_seq_cst, memory_order_relaxed)) {
+			task = NULL;
+		}
+		atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+	}
+
+	return task;
+}
+
+static struct glow_task *deque_steal(struct deque *dq)
+{
+	long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const long b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+	if (t >= b) {
+		return NULL;
+	}
+
+	struct deque_array *a = atomic_load_explicit(&dq->array, memory_order_acquire);
+	struct glow_task *task = atomic_load_explicit(&a->tasks[t & (a->capacity - 1)], memory_order_relaxed);
+
+	if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+	                                             memory_order_seq_cst, memory_order_relaxed)) {
+		return NULL;  /* lost to the owner or another thief */
+	}
+
+	return task;
+}
+
+static struct glow_task *inject_pop(void)
+{
+	GLOW_SAFE(pthread_mutex_lock(&inject_mutex));
+	struct glow_task *task = inject_head;
+
+	if (task != NULL) {
+		inject_head = task->run_next;
+		if (inject_head == NULL) {
+			inject_tail = NULL;
+		}
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&inject_mutex));
+
+	return task;
+}
+
+static void inject_push(struct glow_task *task)
+{
+	task->run_next = NULL;
+
+	GLOW_SAFE(pthread_mutex_lock(&inject_mutex));
+	if (inject_tail != NULL) {
+		inject_tail->run_next = task;
+	} else {
+		inject_head = task;
+	}
+	inject_tail = task;
+	GLOW_SAFE(pthread_mutex_unlock(&inject_mutex));
+}
+
+static inline bool timespec_before(const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+/* `w->mutex` must be held by the timer functions */
+static void timer_add(struct glow_worker *w, struct glow_task *task, const struct timespec *deadline)
+{
+	struct glow_task **link = &w->timers;
+
+	while (*link != NULL && !timespec_before(deadline, &(*link)->deadline)) {
+		link = &(*link)->timer_next;
+	}
+
+	task->deadline = *deadline;
+	task->timer_next = *link;
+	atomic_store_explicit(&task->timed, true, memory_order_relaxed);
+	*link = task;
+	atomic_fetch_add_explicit(&w->n_timers, 1, memory_order_relaxed);
+}
+
+static void timer_remove(struct glow_worker *w, struct glow_task *task)
+{
+	for (struct glow_task **link = &w->timers; *link != NULL; link = &(*link)->timer_next) {
+		if (*link == task) {
+			*link = task->timer_next;
+			break;
+		}
+	}
+
+	task->timer_next = NULL;
+	atomic_store_explicit(&task->timed, false, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&w->n_timers, 1, memory_order_relaxed);
+}
+
+/* `w->mutex` must be held */
+static void run_queue_push(struct glow_worker *w, struct glow_task *task)
+{
+	task->run_next = NULL;
+
+	if (w->run_tail != NULL) {
+		w->run_tail->run_next = task;
+	} else {
+		w->run_head = task;
+	}
+	w->run_tail = task;
+
+	atomic_fetch_add_explicit(&w->n_run, 1, memory_order_relaxed);
+}
+
+static struct glow_task *run_queue_pop(struct glow_worker *w)
+{
+	if (atomic_load_explicit(&w->n_run, memory_order_relaxed) == 0) {
+		return NULL;
+	}
+
+	GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+	struct glow_task *task = w->run_head;
+
+	if (task != NULL) {
+		w->run_head = task->run_next;
+		if (w->run_head == NULL) {
+			w->run_tail = NULL;
+		}
+
+		atomic_fetch_sub_explicit(&w->n_run, 1, memory_order_relaxed);
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+
+	return task;
+}
+
+/*
+ * Puts a parked task back on the run queue of the worker it last ran
+ * on (though any may take it from there); no-op if it isn't parked.
+ */
+static void unpark(struct glow_task *task)
+{
+	if (!atomic_exchange_explicit(&task->parked, false, memory_order_acq_rel)) {
+		return;
+	}
+
+	struct glow_worker *w = task->worker;
+
+	/*
+	 * Its worker is most likely the one to get to it first, so others
+	 * aren't woken for it (nor kept awake by it): if that worker is kept
+	 * busy, the task running there yields (see glow_sched_yield()) and
+	 * wakes them instead.
+	 */
+	GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+	run_queue_push(w, task);
+
+	if (w->sleeping) {
+		GLOW_SAFE(pthread_cond_signal(&w->cond));
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+}
+
+/* switches from a task back to its worker, which may then run it elsewhere */
+static void task_switch_out(struct glow_task *task)
+{
+	GlowVM *vm = glow_current_vm_get();
+	GLOW_SAFE(swapcontext(&task->context, &task->worker->context));
+
+	/* other tasks have had this thread (or it's another thread) in the meantime */
+	glow_current_vm_set(vm);
+}
+
+/*
+ * Switches from a task back to its worker until unpark(). Called with
+ * `mutex` held, which the worker releases only once the switch is done:
+ * whoever unparks the task next is sure to see it parked, and can't
+ * have it resumed (by any worker) before its context has been saved.
+ */
+static void park(struct glow_task *task, pthread_mutex_t *mutex)
+{
+	atomic_store_explicit(&task->parked, true, memory_order_relaxed);
+	task->worker->task_parked_on = mutex;
+	task_switch_out(task);
+	GLOW_SAFE(pthread_mutex_lock(mutex));
+}
+
+/* wakes a worker to pick up newly queued tasks, if none is awake to */
+static void notify_idle(void)
+{
+	if (atomic_load(&n_sleeping) == 0) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < n_workers; i++) {
+		struct glow_worker *w = &workers[i];
+		bool woken = false;
+
+		GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+		if (w->sleeping) {
+			GLOW_SAFE(pthread_cond_signal(&w->cond));
+			woken = true;
+		}
+		GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+
+		if (woken) {
+			break;
+		}
+	}
+}
+
+static void *stack_alloc(struct glow_worker *w)
+{
+	if (w->n_stacks > 0) {
+		return w->stacks[--w->n_stacks];
+	}
+
+	void *stack = mmap(NULL,
+	                   page_size + stack_size,
+	                   PROT_READ | PROT_WRITE,
+	                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+	                   -1,
+	                   0);
+
+	if (stack == MAP_FAILED) {
+		GLOW_INTERNAL_ERROR();
+	}
+
+	/* stacks grow down, into the guard page */
+	GLOW_SAFE(mprotect(stack, page_size, PROT_NONE));
+	return stack;
+}
+
+static void stack_free(struct glow_worker *w, void *stack)
+{
+	if (w->n_stacks < STACK_CACHE_SIZE) {
+		w->stacks[w->n_stacks++] = stack;
+	} else {
+		GLOW_SAFE(munmap(stack, page_size + stack_size));
+	}
+}
+
+static void task_entry(void)
+{
+	struct glow_task *task = current_worker->current;
+	task->run(task);
+
+	/* what the task leaves behind is left to reference counting */
+	glow_gc_thread_exit();
+	glow_refcnt_thread_exit();
+
+	/* the worker (not necessarily the first one) finishes the task off; its stack is about to go */
+	struct glow_worker *w = task->worker;
+	w->task_done = true;
+	setcontext(&w->context);
+}
+
+static void run_task(struct glow_worker *w, struct glow_task *task)
+{
+	if (task->stack == NULL) {
+		task->worker = w;
+		task->stack = stack_alloc(w);
+		task->gc = glow_gc_state_new();
+
+		GLOW_SAFE(getcontext(&task->context));
+		task->context.uc_stack.ss_sp = (char *)task->stack + page_size;
+		task->context.uc_stack.ss_size = stack_size;
+		task->context.uc_link = NULL;
+		makecontext(&task->context, task_entry, 0);
+	} else {
+		/* woken before its timer went off, possibly on another worker */
+		struct glow_worker *last = task->worker;
+
+		if (atomic_load_explicit(&task->timed, memory_order_relaxed)) {
+			GLOW_SAFE(pthread_mutex_lock(&last->mutex));
+			if (atomic_load_explicit(&task->timed, memory_order_relaxed)) {
+				timer_remove(last, task);
+			}
+			GLOW_SAFE(pthread_mutex_unlock(&last->mutex));
+		}
+
+		task->worker = w;
+	}
+
+	w->current = task;
+	w->task_done = false;
+	w->task_yielded = false;
+	w->task_parked_on = NULL;
+	const unsigned int owner = glow_refcnt_owner_swap(task->owner);
+	struct glow_gc_state *gc = glow_gc_state_swap(task->gc);
+
+	GLOW_SAFE(swapcontext(&w->context, &task->context));
+
+	glow_gc_state_swap(gc);
+	task->owner = glow_refcnt_owner_swap(owner);
+	w->current = NULL;
+
+	if (w->task_parked_on != NULL) {
+		GLOW_SAFE(pthread_mutex_unlock(w->task_parked_on));
+	} else if (w->task_yielded) {
+		/* behind whatever else is waiting; workers already awake may take it */
+		inject_push(task);
+		atomic_fetch_add(&n_queued, 1);
+	} else if (w->task_done) {
+		stack_free(w, task->stack);
+		glow_gc_state_free(task->gc);
+		task->stack = NULL;
+		task->gc = NULL;
+		task->finish(task);
+	}
+}
+
+static struct glow_task *find_task(struct glow_worker *w)
+{
+	/* resumed tasks go first, so that parked actors drain their mailboxes */
+	struct glow_task *task = run_queue_pop(w);
+
+	if (task != NULL) {
+		return task;
+	}
+
+	task = deque_take(&w->deque);
+
+	if (task == NULL) {
+		task = inject_pop();
+	}
+
+	for (unsigned int i = 1; task == NULL && i < n_workers; i++) {
+		task = deque_steal(&workers[(w->index + i) % n_workers].deque);
+	}
+
+	if (task != NULL) {
+		atomic_fetch_sub(&n_queued, 1);
+		return task;
+	}
+
+	/* other workers' resumed tasks, in case they're busy */
+	for (unsigned int i = 1; task == NULL && i < n_workers; i++) {
+		task = run_queue_pop(&workers[(w->index + i) % n_workers]);
+	}
+
+	return task;
+}
+
+static void fire_timers(struct glow_worker *w)
+{
+	if (atomic_load_explicit(&w->n_timers, memory_order_relaxed) == 0) {
+		return;
+	}
+
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+
+	GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+	while (w->timers != NULL && !timespec_before(&now, &w->timers->deadline)) {
+		struct glow_task *task = w->timers;
+		timer_remove(w, task);
+
+		/* unless something else has woken it already */
+		if (atomic_exchange_explicit(&task->parked, false, memory_order_acq_rel)) {
+			run_queue_push(w, task);
+		}
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+}
+
+/* sleeps until there may be work; returns false once the pool is stopping */
+static bool worker_wait(struct glow_worker *w)
+{
+	bool stop = false;
+
+	GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+	w->sleeping = true;
+	atomic_fetch_add(&n_sleeping, 1);
+
+	if (w->run_head == NULL && atomic_load(&n_queued) <= 0) {
+		if (atomic_load(&stopping)) {
+			stop = true;
+		} else if (w->timers != NULL) {
+			const int n = pthread_cond_timedwait(&w->cond, &w->mutex, &w->timers->deadline);
+
+			if (n != 0 && n != ETIMEDOUT) {
+				GLOW_INTERNAL_ERROR();
+			}
+		} else {
+			GLOW_SAFE(pthread_cond_wait(&w->cond, &w->mutex));
+		}
+	}
+
+	atomic_fetch_sub(&n_sleeping, 1);
+	w->sleeping = false;
+	GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+
+	return !stop;
+}
+
+static void *worker_main(void *args)
+{
+	struct glow_worker *w = args;
+	current_worker = w;
+
+	while (true) {
+		fire_timers(w);
+		struct glow_task *task = find_task(w);
+
+		if (task != NULL) {
+			run_task(w, task);
+		} else if (!worker_wait(w)) {
+			break;
+		}
+	}
+
+	current_worker = NULL;
+	glow_gc_thread_exit();
+	glow_refcnt_thread_exit();
+	glow_slab_thread_exit();
+	return NULL;
+}
+
+static unsigned int pool_size(void)
+{
+	const char *env = getenv(GLOW_WORKERS_ENV);
+
+	if (env != NULL) {
+		const long n = strtol(env, NULL, 10);
+		if (n > 0) {
+			return (unsigned int)n;
+		}
+	}
+
+	const long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	return (ncpu > 0) ? (unsigned int)ncpu : 1;
+}
+
+/* rounded up to whole pages */
+static size_t task_stack_size(void)
+{
+	size_t size = GLOW_TASK_STACK_SIZE;
+	const char *env = getenv(GLOW_STACK_SIZE_ENV);
+
+	if (env != NULL) {
+		const long kib = strtol(env, NULL, 10);
+		if (kib > 0) {
+			size = (size_t)kib * 1024;
+		}
+	}
+
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+static void pool_start(void)
+{
+	GLOW_SAFE(pthread_mutex_lock(&pool_mutex));
+
+	if (workers == NULL) {
+		const unsigned int n = pool_size();
+		page_size = (size_t)sysconf(_SC_PAGESIZE);
+		stack_size = task_stack_size();
+		struct glow_worker *pool = glow_calloc(n, sizeof(struct glow_worker));
+
+		for (unsigned int i = 0; i < n; i++) {
+			struct glow_worker *w = &pool[i];
+			w->index = i;
+			deque_init(&w->deque);
+			GLOW_SAFE(pthread_mutex_init(&w->mutex, NULL));
+			GLOW_SAFE(pthread_cond_init(&w->cond, NULL));
+		}
+
+		workers = pool;
+		n_workers = n;
+
+		for (unsigned int i = 0; i < n; i++) {
+			GLOW_SAFE(pthread_create(&pool[i].thread, NULL, worker_main, &pool[i]));
+		}
+	}
+
+	GLOW_SAFE(pthread_mutex_unlock(&pool_mutex));
+}
+
+void glow_sched_shutdown(void)
+{
+	GLOW_SAFE(pthread_mutex_lock(&pool_mutex));
+
+	if (workers != NULL) {
+		atomic_store(&stopping, true);
+
+		for (unsigned int i = 0; i < n_workers; i++) {
+			struct glow_worker *w = &workers[i];
+			GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+			GLOW_SAFE(pthread_cond_signal(&w->cond));
+			GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+		}
+
+		for (unsigned int i = 0; i < n_workers; i++) {
+			struct glow_worker *w = &workers[i];
+			GLOW_SAFE(pthread_join(w->thread, NULL));
+			deque_dealloc(&w->deque);
+
+			while (w->n_stacks > 0) {
+				GLOW_SAFE(munmap(w->stacks[--w->n_stacks], page_size + stack_size));
+			}
+
+			GLOW_SAFE(pthread_mutex_destroy(&w->mutex));
+			GLOW_SAFE(pthread_cond_destroy(&w->cond));
+		}
+
+		free(workers);
+		workers = NULL;
+		n_workers = 0;
+		atomic_store(&stopping, false);
+	}
+
+	GLOW_SAFE(pthread_mutex_unlock(&pool_mutex));
+}
+
+void glow_sched_task_init(struct glow_task *task,
+                          void (*run)(struct glow_task *task),
+                          void (*finish)(struct glow_task *task))
+{
+	task->run = run;
+	task->finish = finish;
+	task->stack = NULL;
+	task->worker = NULL;
+	task->owner = GLOW_OWNER_UNASSIGNED;
+	task->gc = NULL;
+	atomic_init(&task->parked, false);
+	task->run_next = NULL;
+	task->wait_next = NULL;
+	task->timer_next = NULL;
+	atomic_init(&task->timed, false);
+}
+
+void glow_sched_spawn(struct glow_task *task)
+{
+	struct glow_worker *w = current_worker;
+
+	if (w != NULL) {
+		deque_push(&w->deque, task);
+	} else {
+		pool_start();
+		inject_push(task);
+	}
+
+	atomic_fetch_add(&n_queued, 1);
+	notify_idle();
+}
+
+struct glow_task *glow_sched_current(void)
+{
+	struct glow_worker *w = current_worker;
+	return (w != NULL) ? w->current : NULL;
+}
+
+void glow_sched_yield(void)
+{
+	struct glow_task *task = glow_sched_current();
+
+	if (task == NULL) {
+		return;
+	}
+
+	/* nothing else would fire them while the task keeps its worker busy */
+	struct glow_worker *w = task->worker;
+	fire_timers(w);
+
+	if (atomic_load_explicit(&w->n_run, memory_order_relaxed) == 0 &&
+	    atomic_load_explicit(&n_queued, memory_order_relaxed) <= 0) {
+		return;
+	}
+
+	w->task_yielded = true;
+	task_switch_out(task);
+}
+
+void glow_sched_cond_init(struct glow_sched_cond *cond)
+{
+	GLOW_SAFE(pthread_cond_init(&cond->cond, NULL));
+	cond->waiters = NULL;
+}
+
+void glow_sched_cond_destroy(struct glow_sched_cond *cond)
+{
+	GLOW_SAFE(pthread_cond_destroy(&cond->cond));
+}
+
+void glow_sched_cond_wait(struct glow_sched_cond *cond, pthread_mutex_t *mutex)
+{
+	struct glow_task *task = glow_sched_current();
+
+	if (task == NULL) {
+		GLOW_SAFE(pthread_cond_wait(&cond->cond, mutex));
+		return;
+	}
+
+	task->wait_next = cond->waiters;
+	cond->waiters = task;
+	park(task, mutex);
+}
+
+bool glow_sched_cond_timedwait(struct glow_sched_cond *cond,
+                               pthread_mutex_t *mutex,
+                               const struct timespec *deadline)
+{
+	struct glow_task *task = glow_sched_current();
+
+	if (task == NULL) {
+		const int n = pthread_cond_timedwait(&cond->cond, mutex, deadline);
+
+		if (n != 0 && n != ETIMEDOUT) {
+			GLOW_INTERNAL_ERROR();
+		}
+
+		return n == 0;
+	}
+
+	struct glow_worker *w = task->worker;
+	task->wait_next = cond->waiters;
+	cond->waiters = task;
+
+	GLOW_SAFE(pthread_mutex_lock(&w->mutex));
+	timer_add(w, task, deadline);
+	GLOW_SAFE(pthread_mutex_unlock(&w->mutex));
+
+	park(task, mutex);
+
+	/* still among the waiters if the timer woke us */
+	for (struct glow_task **link = &cond->waiters; *link != NULL; link = &(*link)->wait_next) {
+		if (*link == task) {
+			*link = task->wait_next;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void glow_sched_cond_broadcast(struct glow_sched_cond *cond)
+{
+	GLOW_SAFE(pthread_cond_broadcast(&cond->cond));
+
+	struct glow_task *task = cond->waiters;
+	cond->waiters = NULL;
+
+	while (task != NULL) {
+		struct glow_task *next = task->wait_next;
+		unpark(task);
+		task = next;
+	}
+}
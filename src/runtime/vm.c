@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include <pthread.h>
 #include "compiler.h"
@@ -16,6 +17,7 @@
 #include "tupleobject.h"
 #include "setobject.h"
 #include "dictobject.h"
+#include "iter.h"
 #include "fileobject.h"
 #include "codeobject.h"
 #include "funcobject.h"
@@ -36,6 +38,7 @@
 #include "plugins.h"
 #include "util.h"
 #include "main.h"
+#include "scheduler.h"
 #include "vmops.h"
 #include "vm.h"
 
@@ -114,6 +117,7 @@ static void import_cache_dealloc(void)
 }
 
 static unsigned int get_lineno(GlowFrame *frame);
+static const struct glow_exc_handler *find_exc_handler(GlowCodeObject *co, const size_t pos);
 
 static void vm_push_module_frame(GlowVM *vm, GlowCode *code);
 static void vm_load_builtins(void);
@@ -177,7 +181,7 @@ static void vm_free_helper(GlowVM *vm)
 		glow_release(&globals[i]);
 	}
 
-	free(globals);
+	glow_frame_free(vm->module);
 	free(vm->global_names.array);
 
 	for (GlowVM *child = vm->children; child != NULL;) {
@@ -244,37 +248,72 @@ int glow_vm_exec_code(GlowVM *vm, GlowCode *code)
  * Important note about the references Frames and CodeObjects have for one another:
  *
  * Frames have a `co` field which points to the CodeObject they are currently executing.
- * Similarly, CodeObjects have a `frame` field that points to the Frame that *finished*
- * executing them (this is used to avoid unnecessary creation of Frames). The point is
- * that a Frame's `co` field is only valid once that Frame is pushed, while a CodeObject's
- * `frame` field is only valid while that CodeObject is no longer being executed. In this
- * way, we resolve the issue of any circular dependencies and avoid running into problems
- * with recursive functions (CodeObjects actually retain the highest-level Frame in the
- * case of recursive calls).
+ * Similarly, CodeObjects have a `frame_pool` field: a LIFO list (linked through `prev`)
+ * of Frames that *finished* executing them, which are reused by later calls instead of
+ * allocating new ones. The point is that a Frame's `co` field is only valid once that
+ * Frame is pushed, while a Frame is only in its CodeObject's pool while it is no longer
+ * being executed. In this way, we resolve the issue of any circular dependencies, and
+ * recursive functions find one pooled Frame per level of recursion (up to
+ * GLOW_FRAME_POOL_MAX). The pool is shared by all threads running the CodeObject, so
+ * it is guarded by a spinlock.
  */
 
+#define GLOW_FRAME_POOL_MAX 32
+
+static inline void frame_pool_lock(GlowCodeObject *co)
+{
+	while (atomic_flag_test_and_set_explicit(&co->frame_pool_lock, memory_order_acquire));
+}
+
+static inline void frame_pool_unlock(GlowCodeObject *co)
+{
+	atomic_flag_clear_explicit(&co->frame_pool_lock, memory_order_release);
+}
+
 static GlowFrame *get_frame(GlowCodeObject *co)
 {
-	GlowFrame *frame = co->frame;
-	co->frame = NULL;
+	frame_pool_lock(co);
+	GlowFrame *frame = co->frame_pool;
+	if (frame != NULL) {
+		co->frame_pool = frame->prev;
+		--co->frame_pool_size;
+	}
+	frame_pool_unlock(co);
 
 	if (frame == NULL) {
-		goto new_frame;
+		frame = glow_frame_make(co);
 	}
 
-	const bool owned = atomic_flag_test_and_set(&frame->owned);
+	frame->co = co;
+	return frame;
+}
 
-	if (!owned) {
-		frame->co = co;
-		return frame;
-	} else {
-		goto new_frame;
+static void put_frame(GlowCodeObject *co, GlowFrame *frame)
+{
+	frame_pool_lock(co);
+	if (co->frame_pool_size < GLOW_FRAME_POOL_MAX) {
+		frame->prev = co->frame_pool;
+		co->frame_pool = frame;
+		++co->frame_pool_size;
+		frame = NULL;
 	}
+	frame_pool_unlock(co);
 
-	new_frame:
-	frame = glow_frame_make(co);
-	frame->co = co;
-	return frame;
+	glow_frame_free(frame);
+}
+
+void glow_frame_pool_free(GlowCodeObject *co)
+{
+	GlowFrame *frame = co->frame_pool;
+
+	while (frame != NULL) {
+		GlowFrame *prev = frame->prev;
+		glow_frame_free(frame);
+		frame = prev;
+	}
+
+	co->frame_pool = NULL;
+	co->frame_pool_size = 0;
 }
 
 void glow_vm_push_frame(GlowVM *vm, GlowCodeObject *co)
@@ -287,6 +326,7 @@ void glow_vm_push_frame_direct(GlowVM *vm, GlowFrame *frame)
 {
 	frame->active = 1;
 	frame->top_level = (vm->callstack == NULL);
+	frame->inline_call = 0;
 	frame->prev = vm->callstack;
 	vm->callstack = frame;
 }
@@ -299,56 +339,42 @@ void glow_vm_pop_frame(GlowVM *vm)
 	GlowCodeObject *co = frame->co;
 	frame->active = 0;
 	frame->co = NULL;
-	atomic_flag_clear(&frame->owned);
 
 	if (co != NULL) {
 		if (!frame->persistent) {
-			if (co->frame == NULL) {
-				co->frame = frame;
-			} else {
-				glow_frame_free(frame);
-			}
+			put_frame(co, frame);
 		}
 		glow_releaseo(co);
 	}
 }
 
+/*
+ * A frame is allocated as a single block: the GlowFrame itself, followed
+ * by its locals and its value stack.
+ */
 GlowFrame *glow_frame_make(GlowCodeObject *co)
 {
-	GlowFrame *frame = glow_malloc(sizeof(GlowFrame));
-
 	const size_t n_locals = co->names.length;
 	const size_t stack_depth = co->stack_depth;
-	const size_t try_catch_depth = co->try_catch_depth;
+
+	GlowFrame *frame = glow_calloc(1, sizeof(GlowFrame) +
+	                                  (n_locals + stack_depth) * sizeof(GlowValue));
 
 	frame->co = NULL;  // `co` field only valid when frame is being executed
-	frame->locals = glow_calloc(n_locals + stack_depth, sizeof(GlowValue));
+	frame->locals = (GlowValue *)(frame + 1);
 	frame->n_locals = n_locals;
 
 	frame->val_stack = frame->val_stack_base = frame->locals + n_locals;
 
-	const size_t frees_len = co->frees.length;
-	GlowStr *frees = glow_malloc(frees_len * sizeof(GlowStr));
-	for (size_t i = 0; i < frees_len; i++) {
-		frees[i] = GLOW_STR_INIT(co->frees.array[i].str, co->frees.array[i].length, 0);
-	}
-	frame->frees = frees;
-
-	frame->exc_stack_base =
-	        frame->exc_stack =
-	                glow_malloc(try_catch_depth * sizeof(struct glow_exc_stack_element));
-
 	frame->pos = 0;
 	frame->return_value = glow_makeempty();
 	frame->mailbox = NULL;
-	static atomic_flag flag = ATOMIC_FLAG_INIT;
-	frame->owned = flag;
-	atomic_flag_clear(&frame->owned);
 
 	frame->active = 0;
 	frame->persistent = 0;
 	frame->top_level = 0;
 	frame->force_free_locals = 0;
+	frame->inline_call = 0;
 
 	return frame;
 }
@@ -356,12 +382,10 @@ GlowFrame *glow_frame_make(GlowCodeObject *co)
 void glow_frame_save_state(GlowFrame *frame,
                           const size_t pos,
                           GlowValue ret_val,
-                          GlowValue *val_stack,
-                          struct glow_exc_stack_element *exc_stack)
+                          GlowValue *val_stack)
 {
 	frame->pos = pos;
 	frame->val_stack = val_stack;
-	frame->exc_stack = exc_stack;
 	glow_release(&frame->return_value);
 	frame->return_value = ret_val;
 }
@@ -381,7 +405,6 @@ void glow_frame_reset(GlowFrame *frame)
 	glow_release(&frame->return_value);
 	frame->return_value = glow_makeempty();
 	frame->val_stack = frame->val_stack_base;
-	frame->exc_stack = frame->exc_stack_base;
 	frame->pos = 0;
 }
 
@@ -397,26 +420,19 @@ void glow_frame_free(GlowFrame *frame)
 		glow_release(--val_stack);
 	}
 
-	glow_frame_reset(frame);
-
 	/*
-	 * We don't free the module-level local variables,
-	 * because these are actually global variables and
-	 * may still be referred to via imports. These will
-	 * eventually be freed once the VM instance itself
-	 * is freed.
+	 * This doesn't release the module-level local variables,
+	 * because these are actually global variables and may
+	 * still be referred to via imports. The module frame is
+	 * freed along with the VM instance itself.
 	 */
-	if (!frame->top_level || frame->force_free_locals) {
-		free(frame->locals);
-	}
+	glow_frame_reset(frame);
 
 	if (frame->co != NULL) {
 		glow_releaseo(frame->co);
 	}
 
 	glow_release(&frame->return_value);
-	free(frame->frees);
-	free(frame->exc_stack_base);
 	free(frame);
 }
 
@@ -429,11 +445,325 @@ static void vm_push_module_frame(GlowVM *vm, GlowCode *code)
 	GlowCodeObject *co = glow_codeobj_make_toplevel(code, "<module>", vm);
 	glow_vm_push_frame(vm, co);
 	vm->module = vm->callstack;
+	vm->module->persistent = 1;  // owns the globals; freed with the VM
 	vm->globals = (struct glow_value_array){.array = vm->module->locals,
 	                                       .length = vm->module->n_locals};
 	glow_util_str_array_dup(&co->names, &vm->global_names);
 }
 
+/*
+ * Attribute inline caches; see struct glow_attr_cache.
+ */
+static pthread_mutex_t attr_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline bool attr_cache_lookup(struct glow_attr_cache *ac, const GlowClass *class, unsigned int *value)
+{
+	for (size_t i = 0; i < GLOW_ATTR_CACHE_SIZE; i++) {
+		const GlowClass *c = atomic_load_explicit(&ac->classes[i], memory_order_acquire);
+
+		if (c == class) {
+			*value = ac->values[i];
+			return true;
+		}
+
+		if (c == NULL) {
+			break;
+		}
+	}
+
+	return false;
+}
+
+static void attr_cache_add(struct glow_attr_cache *ac, GlowClass *class, const unsigned int value)
+{
+	GLOW_SAFE(pthread_mutex_lock(&attr_cache_mutex));
+	for (size_t i = 0; i < GLOW_ATTR_CACHE_SIZE; i++) {
+		const GlowClass *c = atomic_load_explicit(&ac->classes[i], memory_order_relaxed);
+
+		if (c == class) {
+			break;
+		}
+
+		if (c == NULL) {
+			ac->values[i] = value;
+			atomic_store_explicit(&ac->classes[i], class, memory_order_release);
+			break;
+		}
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&attr_cache_mutex));
+}
+
+/*
+ * Finds the attribute dictionary value of `attr` for `class` through
+ * the cache of the instruction at `ins`. Returns false if the class
+ * handles attributes itself (or the instruction has no cache), in
+ * which case the generic glow_op_*_attr() path must be used.
+ */
+static inline bool attr_cache_resolve(GlowCodeObject *co,
+                                      const size_t ins,
+                                      GlowClass *class,
+                                      const char *attr,
+                                      const bool set,
+                                      unsigned int *value)
+{
+	const unsigned int index = co->cache[ins].attr_cache;
+
+	if (index == 0) {
+		return false;
+	}
+
+	struct glow_attr_cache *ac = &co->attr_caches[index - 1];
+
+	if (attr_cache_lookup(ac, class, value)) {
+		return true;
+	}
+
+	if (set ? (glow_resolve_attr_set(class) != NULL) : (glow_resolve_attr_get(class) != NULL)) {
+		return false;
+	}
+
+	*value = glow_attr_dict_get(&class->attr_dict, attr);
+
+	if (*value & GLOW_ATTR_DICT_FLAG_FOUND) {
+		attr_cache_add(ac, class, *value);
+	}
+
+	return true;
+}
+
+/*
+ * When the compiler supports labels-as-values, the eval loop dispatches
+ * each opcode with an indirect jump from the end of the previous opcode's
+ * body ("direct threading"), which gives every opcode its own branch
+ * prediction slot. Otherwise (or if GLOW_NO_COMPUTED_GOTO is defined), we
+ * fall back to the portable switch.
+ */
+#if defined(__GNUC__) && !defined(GLOW_NO_COMPUTED_GOTO)
+#define GLOW_USE_COMPUTED_GOTO 1
+#else
+#define GLOW_USE_COMPUTED_GOTO 0
+#endif
+
+/*
+ * Quickening: generic arithmetic and comparison instructions rewrite
+ * themselves in place into type-specialized variants (e.g. ADD_INT_INT)
+ * once they see matching operand types. A specialized instruction
+ * guards its operand types and, if the guard fails (or an integer
+ * operation would overflow), rewrites itself back to the generic form
+ * and waits GLOW_QUICKEN_BACKOFF executions before specializing again.
+ * Define GLOW_NO_QUICKENING to disable.
+ */
+#ifndef GLOW_NO_QUICKENING
+#define GLOW_USE_QUICKENING 1
+#else
+#define GLOW_USE_QUICKENING 0
+#endif
+
+#define GLOW_QUICKEN_BACKOFF 64
+
+/* backward jumps between yields to other actors, so that a busy loop can't hog its worker */
+#define GLOW_YIELD_INTERVAL 1024
+
+/*
+ * Actors running the same code rewrite its opcodes concurrently (see
+ * QUICKEN), so these are only loaded and stored atomically. The
+ * specialized opcode is published with a release store once the
+ * generic one has been recorded, and deoptimizing acquires it, so the
+ * opcode restored is never a stale 0. Functions rather than macros so
+ * that unoptimized builds don't give each expansion its own stack slot.
+ */
+static inline byte opcode_load(byte *p)
+{
+	return atomic_load_explicit((_Atomic byte *)p, memory_order_relaxed);
+}
+
+static inline void opcode_quicken(byte *p, struct glow_code_cache *cache, const byte generic_op, const byte op)
+{
+	atomic_store_explicit(&cache->generic_op, generic_op, memory_order_relaxed);
+	atomic_store_explicit((_Atomic byte *)p, op, memory_order_release);
+}
+
+/* the opcode at `p` must have been loaded already, and be a specialized one */
+static inline void opcode_deopt(byte *p, struct glow_code_cache *cache)
+{
+	atomic_thread_fence(memory_order_acquire);
+	const byte generic_op = atomic_load_explicit(&cache->generic_op, memory_order_relaxed);
+	atomic_store_explicit((_Atomic byte *)p, generic_op, memory_order_relaxed);
+	atomic_store_explicit(&cache->backoff, GLOW_QUICKEN_BACKOFF, memory_order_relaxed);
+}
+
+/* whether to hold off specializing for now */
+static inline bool quicken_backoff(struct glow_code_cache *cache)
+{
+	const byte n = atomic_load_explicit(&cache->backoff, memory_order_relaxed);
+
+	if (n > 0) {
+		atomic_store_explicit(&cache->backoff, n - 1, memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+static inline bool int_add_overflow(const long a, const long b, long *res)
+{
+#if defined(__GNUC__)
+	return __builtin_add_overflow(a, b, res);
+#else
+	if ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b)) {
+		return true;
+	}
+	*res = a + b;
+	return false;
+#endif
+}
+
+static inline bool int_sub_overflow(const long a, const long b, long *res)
+{
+#if defined(__GNUC__)
+	return __builtin_sub_overflow(a, b, res);
+#else
+	if ((b < 0 && a > LONG_MAX + b) || (b > 0 && a < LONG_MIN + b)) {
+		return true;
+	}
+	*res = a - b;
+	return false;
+#endif
+}
+
+static inline bool int_mul_overflow(const long a, const long b, long *res)
+{
+#if defined(__GNUC__)
+	return __builtin_mul_overflow(a, b, res);
+#else
+	if (a > 0) {
+		if ((b > 0 && a > LONG_MAX / b) || (b <= 0 && b < LONG_MIN / a)) {
+			return true;
+		}
+	} else if (a < 0) {
+		if ((b > 0 && a < LONG_MIN / b) || (b < 0 && b < LONG_MAX / a)) {
+			return true;
+		}
+	}
+	*res = a * b;
+	return false;
+#endif
+}
+
+/*
+ * Advances iterators over built-in containers in place of
+ * glow_op_iternext(), storing the next element in `next` (or an
+ * empty value once exhausted). Returns false if `iter` has to take
+ * the generic path instead: other iterators, safe'd or foreign
+ * sources, and sources modified during iteration, whose error the
+ * generic path raises.
+ */
+static inline bool iternext_fast(GlowValue *iter, GlowValue *next)
+{
+	const GlowClass *class = glow_getclass(iter);
+
+	if (class == &glow_list_iter_class) {
+		GlowListIter *it = glow_objvalue(iter);
+		GlowListObject *list = it->source;
+
+		if (!GLOW_IS_LOCAL_UNGUARDED(list)) {
+			return false;
+		}
+
+		if (it->index < list->count) {
+			*next = list->elements[it->index++];
+			glow_retain(next);
+		} else {
+			*next = glow_makeempty();
+		}
+
+		return true;
+	}
+
+	if (class == &glow_range_class) {
+		GlowRange *range = glow_objvalue(iter);
+
+		if (!GLOW_IS_LOCAL_UNGUARDED(range)) {
+			return false;
+		}
+
+		const long i = range->i;
+
+		if (range->to >= range->from ? i < range->to : i >= range->to) {
+			range->i = (range->to >= range->from) ? i + 1 : i - 1;
+			*next = glow_makeint(i);
+		} else {
+			*next = glow_makeempty();
+		}
+
+		return true;
+	}
+
+	if (class == &glow_dict_iter_class) {
+		GlowDictIter *it = glow_objvalue(iter);
+		GlowDictObject *dict = it->source;
+
+		if (!GLOW_IS_LOCAL_UNGUARDED(dict) || it->saved_state_id != dict->state_id) {
+			return false;
+		}
+
+		struct glow_dict_entry *entries = dict->entries;
+		const size_t n_entries = dict->n_entries;
+		size_t idx = it->current_index;
+
+		while (idx < n_entries && glow_isempty(&entries[idx].key)) {
+			++idx;
+		}
+
+		if (idx < n_entries) {
+			GlowValue pair[] = {entries[idx].key, entries[idx].value};
+			glow_retain(&pair[0]);
+			glow_retain(&pair[1]);
+			*next = glow_tuple_make(pair, 2);
+			++idx;
+		} else {
+			*next = glow_makeempty();
+		}
+
+		it->current_index = idx;
+		return true;
+	}
+
+	if (class == &glow_set_iter_class) {
+		GlowSetIter *it = glow_objvalue(iter);
+		GlowSetObject *set = it->source;
+
+		if (!GLOW_IS_LOCAL_UNGUARDED(set) || it->saved_state_id != set->state_id) {
+			return false;
+		}
+
+		const size_t capacity = set->capacity;
+		size_t idx = it->current_index;
+
+		while (idx < capacity && set->ctrl[idx] < 0) {
+			++idx;
+		}
+
+		if (idx < capacity) {
+			*next = set->slots[idx].element;
+			glow_retain(next);
+			++idx;
+		} else {
+			*next = glow_makeempty();
+		}
+
+		it->current_index = idx;
+		return true;
+	}
+
+	return false;
+}
+
+#if GLOW_USE_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
 void glow_vm_eval_frame(GlowVM *vm)
 {
 #define GET_BYTE()    (bc[pos++])
@@ -452,67 +782,369 @@ void glow_vm_eval_frame(GlowVM *vm)
 #define STACK_SET_THIRD(v)   (stack[-3] = (v))
 #define STACK_PURGE(wall)    do { while (stack != wall) { glow_release(STACK_POP());} } while (0)
 
-#define EXC_STACK_PUSH(start, end, handler, purge_wall) \
-	(*exc_stack++ = (struct glow_exc_stack_element){(start), (end), (handler), (purge_wall)})
-#define EXC_STACK_POP()       (--exc_stack)
-#define EXC_STACK_TOP()       (&exc_stack[-1])
-#define EXC_STACK_EMPTY()     (exc_stack == exc_stack_base)
-
-	GlowFrame *frame = vm->callstack;
+/*
+ * Calls to FuncObjects made by CALL/CALL_METHOD don't recurse into this
+ * function: the caller's `pos` and `stack` are saved in its frame, the
+ * callee's frame is pushed with `inline_call` set and loaded here, and
+ * once it returns (or throws) we pop it and reload the caller's frame.
+ */
+#define LOAD_FRAME() \
+	do { \
+		frame = vm->callstack; \
+		locals = frame->locals; \
+		co = frame->co; \
+		frees = co->free_keys; \
+		globals = co->vm->globals.array; \
+		symbols = co->names; \
+		attrs = co->attrs; \
+		global_symbols = co->vm->global_names; \
+		constants = co->consts.array; \
+		bc = co->bc; \
+		cache = co->cache; \
+		stack_base = frame->val_stack_base; \
+		stack = frame->val_stack; \
+		ret_hint = GLOW_CODEOBJ_RET_HINT(co); \
+		mb = frame->mailbox; \
+		pos = frame->pos; \
+	} while (0)
+
+#define SAVE_FRAME() \
+	do { \
+		frame->pos = pos; \
+		frame->val_stack = stack; \
+	} while (0)
+
+/* releases the arguments of a CALL/CALL_METHOD */
+#define STACK_POP_ARGS(nargs, nargs_named) \
+	do { \
+		for (unsigned int _i = 0; _i < (nargs_named); _i++) { \
+			glow_release(STACK_POP());  /* value */ \
+			glow_release(STACK_POP());  /* name */ \
+		} \
+		for (unsigned int _i = 0; _i < (nargs); _i++) { \
+			glow_release(STACK_POP()); \
+		} \
+	} while (0)
+
+/* enters a call of FuncObject `fn`, which has been popped off the stack */
+#define CALL_INLINE(fn, args, args_named, nargs, nargs_named) \
+	do { \
+		res = glow_funcobj_push_frame(vm, glow_objvalue(fn), (args), (args_named), (nargs), (nargs_named)); \
+		glow_release(fn); \
+		if (glow_iserror(&res)) { \
+			goto error; \
+		} \
+		STACK_POP_ARGS(nargs, nargs_named); \
+		SAVE_FRAME(); \
+		vm->callstack->inline_call = 1; \
+		LOAD_FRAME(); \
+		DISPATCH(); \
+	} while (0)
+
+/* pushed by LOAD_METHOD: unbound method to call, or NULL */
+#define METHOD_MARKER(m)     glow_makeptr(m)
 
-	GlowValue *locals = frame->locals;
-	GlowStr *frees = frame->frees;
-	GlowCodeObject *co = frame->co;
-	const GlowVM *co_vm = co->vm;
-	GlowValue *globals = co_vm->globals.array;
+/*
+ * Note that `frame->pos` is deliberately not updated as we go; the
+ * error section and PRODUCE store `pos` back into the frame when
+ * they need it.
+ */
+#define FETCH()  (opcode = opcode_load(&bc[pos++]))
+
+#if GLOW_USE_COMPUTED_GOTO
+#define TARGET(op)       TARGET_##op: case op
+#define TARGET_DEFAULT   TARGET_INVALID: default
+#define DISPATCH()  do { FETCH(); goto *dispatch_table[opcode]; } while (0)
+#else
+#define TARGET(op)       case op
+#define TARGET_DEFAULT   default
+#define DISPATCH()  goto head  /* not `continue`, so it also works inside do-while macros */
+#endif
 
-	const struct glow_str_array symbols = co->names;
-	const struct glow_str_array attrs = co->attrs;
-	const struct glow_str_array global_symbols = co_vm->global_names;
+#define BACK_EDGE() \
+	do { \
+		if (--back_edges == 0) { \
+			back_edges = GLOW_YIELD_INTERVAL; \
+			glow_sched_yield(); \
+		} \
+	} while (0)
 
-	GlowValue *constants = co->consts.array;
-	const byte *bc = co->bc;
-	const GlowValue *stack_base = frame->val_stack_base;
-	GlowValue *stack = frame->val_stack;
-	GlowClass *ret_hint = GLOW_CODEOBJ_RET_HINT(co);
+/*
+ * Quickening helpers; these apply to argument-less instructions only,
+ * so the instruction being executed is always at `pos - 1`. Both
+ * QUICKEN and DEOPT re-execute the rewritten instruction.
+ *
+ * An actor running the same code concurrently sees either the generic
+ * or the specialized opcode (see opcode_load()), and both are correct
+ * since specialized instructions check their guards.
+ */
+#if GLOW_USE_QUICKENING
+#define QUICKEN(op) \
+	do { \
+		opcode_quicken(&bc[pos - 1], &cache[pos - 1], opcode, (op)); \
+		--pos; \
+		DISPATCH(); \
+	} while (0)
+
+#define TRY_QUICKEN(int_op, float_op) \
+	do { \
+		if (quicken_backoff(&cache[pos - 1])) { \
+			break; \
+		} \
+		const GlowValue *_qa = STACK_SECOND(); \
+		const GlowValue *_qb = STACK_TOP(); \
+		if ((int_op) != 0 && glow_isint(_qa) && glow_isint(_qb)) { \
+			QUICKEN(int_op); \
+		} \
+		if ((float_op) != 0 && glow_isfloat(_qa) && glow_isfloat(_qb)) { \
+			QUICKEN(float_op); \
+		} \
+	} while (0)
+#else
+#define TRY_QUICKEN(int_op, float_op)
+#endif
 
-	const struct glow_exc_stack_element *exc_stack_base = frame->exc_stack_base;
-	struct glow_exc_stack_element *exc_stack = frame->exc_stack;
-	struct glow_mailbox *mb = frame->mailbox;
+#define DEOPT() \
+	do { \
+		opcode_deopt(&bc[pos - 1], &cache[pos - 1]); \
+		--pos; \
+		DISPATCH(); \
+	} while (0)
+
+#define QUICK_INT_ARITH(overflow_check) \
+	do { \
+		long _r; \
+		v2 = STACK_TOP(); \
+		v1 = STACK_SECOND(); \
+		if (!glow_isint(v1) || !glow_isint(v2) || \
+		    overflow_check(glow_intvalue(v1), glow_intvalue(v2), &_r) || \
+		    !glow_int_fits(_r)) { \
+			DEOPT(); \
+		} \
+		STACK_POP(); \
+		STACK_SET_TOP(glow_makeint(_r)); \
+	} while (0)
+
+#define QUICK_INT_CMP(make, tok) \
+	do { \
+		v2 = STACK_TOP(); \
+		v1 = STACK_SECOND(); \
+		if (!glow_isint(v1) || !glow_isint(v2)) { \
+			DEOPT(); \
+		} \
+		STACK_POP(); \
+		STACK_SET_TOP(make(glow_intvalue(v1) tok glow_intvalue(v2))); \
+	} while (0)
+
+#define QUICK_FLOAT_ARITH(tok) \
+	do { \
+		v2 = STACK_TOP(); \
+		v1 = STACK_SECOND(); \
+		if (!glow_isfloat(v1) || !glow_isfloat(v2)) { \
+			DEOPT(); \
+		} \
+		STACK_POP(); \
+		STACK_SET_TOP(glow_makefloat(glow_floatvalue(v1) tok glow_floatvalue(v2))); \
+	} while (0)
+
+/* mirrors float_cmp() so that NaN operands behave exactly as in the generic path */
+#define QUICK_FLOAT_CMP(tok) \
+	do { \
+		v2 = STACK_TOP(); \
+		v1 = STACK_SECOND(); \
+		if (!glow_isfloat(v1) || !glow_isfloat(v2)) { \
+			DEOPT(); \
+		} \
+		const double _x = glow_floatvalue(v1); \
+		const double _y = glow_floatvalue(v2); \
+		const int _c = (_x < _y) ? -1 : ((_x == _y) ? 0 : 1); \
+		STACK_POP(); \
+		STACK_SET_TOP(glow_makeint(_c tok 0)); \
+	} while (0)
+
+	GlowFrame *frame;
+
+	GlowValue *locals;
+	GlowStr *frees;
+	GlowCodeObject *co;
+	GlowValue *globals;
+
+	struct glow_str_array symbols;
+	struct glow_str_array attrs;
+	struct glow_str_array global_symbols;
+
+	GlowValue *constants;
+	byte *bc;
+	struct glow_code_cache *cache;
+	const GlowValue *stack_base;
+	GlowValue *stack;
+	GlowClass *ret_hint;
+
+	struct glow_mailbox *mb;
 
 	/* position in the bytecode */
-	size_t pos = frame->pos;
+	size_t pos;
+
+	unsigned int back_edges = GLOW_YIELD_INTERVAL;
+
+	LOAD_FRAME();
 
 	GlowValue *v1, *v2, *v3;
 	GlowValue res;
+	byte opcode;
+
+#if GLOW_USE_COMPUTED_GOTO
+	/*
+	 * Indexed by opcode and covering every byte value, so that invalid
+	 * ones (from a corrupt .glowc, say) fail like in the switch.
+	 */
+#define OPCODE_TARGET(op) [op] = &&TARGET_##op
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+	static void *const dispatch_table[256] = {
+		[0 ... 255] = &&TARGET_INVALID,
+		OPCODE_TARGET(GLOW_INS_NOP),
+		OPCODE_TARGET(GLOW_INS_LOAD_CONST),
+		OPCODE_TARGET(GLOW_INS_LOAD_NULL),
+		OPCODE_TARGET(GLOW_INS_LOAD_ITER_STOP),
+		OPCODE_TARGET(GLOW_INS_ADD),
+		OPCODE_TARGET(GLOW_INS_SUB),
+		OPCODE_TARGET(GLOW_INS_MUL),
+		OPCODE_TARGET(GLOW_INS_DIV),
+		OPCODE_TARGET(GLOW_INS_MOD),
+		OPCODE_TARGET(GLOW_INS_POW),
+		OPCODE_TARGET(GLOW_INS_BITAND),
+		OPCODE_TARGET(GLOW_INS_BITOR),
+		OPCODE_TARGET(GLOW_INS_XOR),
+		OPCODE_TARGET(GLOW_INS_BITNOT),
+		OPCODE_TARGET(GLOW_INS_SHIFTL),
+		OPCODE_TARGET(GLOW_INS_SHIFTR),
+		OPCODE_TARGET(GLOW_INS_AND),
+		OPCODE_TARGET(GLOW_INS_OR),
+		OPCODE_TARGET(GLOW_INS_NOT),
+		OPCODE_TARGET(GLOW_INS_EQUAL),
+		OPCODE_TARGET(GLOW_INS_NOTEQ),
+		OPCODE_TARGET(GLOW_INS_LT),
+		OPCODE_TARGET(GLOW_INS_GT),
+		OPCODE_TARGET(GLOW_INS_LE),
+		OPCODE_TARGET(GLOW_INS_GE),
+		OPCODE_TARGET(GLOW_INS_UPLUS),
+		OPCODE_TARGET(GLOW_INS_UMINUS),
+		OPCODE_TARGET(GLOW_INS_IADD),
+		OPCODE_TARGET(GLOW_INS_ISUB),
+		OPCODE_TARGET(GLOW_INS_IMUL),
+		OPCODE_TARGET(GLOW_INS_IDIV),
+		OPCODE_TARGET(GLOW_INS_IMOD),
+		OPCODE_TARGET(GLOW_INS_IPOW),
+		OPCODE_TARGET(GLOW_INS_IBITAND),
+		OPCODE_TARGET(GLOW_INS_IBITOR),
+		OPCODE_TARGET(GLOW_INS_IXOR),
+		OPCODE_TARGET(GLOW_INS_ISHIFTL),
+		OPCODE_TARGET(GLOW_INS_ISHIFTR),
+		OPCODE_TARGET(GLOW_INS_MAKE_RANGE),
+		OPCODE_TARGET(GLOW_INS_IN),
+		OPCODE_TARGET(GLOW_INS_STORE),
+		OPCODE_TARGET(GLOW_INS_STORE_GLOBAL),
+		OPCODE_TARGET(GLOW_INS_LOAD),
+		OPCODE_TARGET(GLOW_INS_LOAD_GLOBAL),
+		OPCODE_TARGET(GLOW_INS_LOAD_ATTR),
+		OPCODE_TARGET(GLOW_INS_SET_ATTR),
+		OPCODE_TARGET(GLOW_INS_LOAD_INDEX),
+		OPCODE_TARGET(GLOW_INS_SET_INDEX),
+		OPCODE_TARGET(GLOW_INS_APPLY),
+		OPCODE_TARGET(GLOW_INS_IAPPLY),
+		OPCODE_TARGET(GLOW_INS_LOAD_NAME),
+		OPCODE_TARGET(GLOW_INS_PRINT),
+		OPCODE_TARGET(GLOW_INS_JMP),
+		OPCODE_TARGET(GLOW_INS_JMP_BACK),
+		OPCODE_TARGET(GLOW_INS_JMP_IF_TRUE),
+		OPCODE_TARGET(GLOW_INS_JMP_IF_FALSE),
+		OPCODE_TARGET(GLOW_INS_JMP_BACK_IF_TRUE),
+		OPCODE_TARGET(GLOW_INS_JMP_BACK_IF_FALSE),
+		OPCODE_TARGET(GLOW_INS_JMP_IF_TRUE_ELSE_POP),
+		OPCODE_TARGET(GLOW_INS_JMP_IF_FALSE_ELSE_POP),
+		OPCODE_TARGET(GLOW_INS_CALL),
+		OPCODE_TARGET(GLOW_INS_RETURN),
+		OPCODE_TARGET(GLOW_INS_THROW),
+		OPCODE_TARGET(GLOW_INS_PRODUCE),
+		OPCODE_TARGET(GLOW_INS_JMP_IF_EXC_MISMATCH),
+		OPCODE_TARGET(GLOW_INS_MAKE_LIST),
+		OPCODE_TARGET(GLOW_INS_MAKE_TUPLE),
+		OPCODE_TARGET(GLOW_INS_MAKE_SET),
+		OPCODE_TARGET(GLOW_INS_MAKE_DICT),
+		OPCODE_TARGET(GLOW_INS_IMPORT),
+		OPCODE_TARGET(GLOW_INS_EXPORT),
+		OPCODE_TARGET(GLOW_INS_EXPORT_GLOBAL),
+		OPCODE_TARGET(GLOW_INS_EXPORT_NAME),
+		OPCODE_TARGET(GLOW_INS_RECEIVE),
+		OPCODE_TARGET(GLOW_INS_GET_ITER),
+		OPCODE_TARGET(GLOW_INS_LOOP_ITER),
+		OPCODE_TARGET(GLOW_INS_MAKE_FUNCOBJ),
+		OPCODE_TARGET(GLOW_INS_MAKE_GENERATOR),
+		OPCODE_TARGET(GLOW_INS_MAKE_ACTOR),
+		OPCODE_TARGET(GLOW_INS_SEQ_EXPAND),
+		OPCODE_TARGET(GLOW_INS_POP),
+		OPCODE_TARGET(GLOW_INS_DUP),
+		OPCODE_TARGET(GLOW_INS_DUP_TWO),
+		OPCODE_TARGET(GLOW_INS_ROT),
+		OPCODE_TARGET(GLOW_INS_ROT_THREE),
+		OPCODE_TARGET(GLOW_INS_LOAD_METHOD),
+		OPCODE_TARGET(GLOW_INS_CALL_METHOD),
+		OPCODE_TARGET(GLOW_INS_LEN),
+		OPCODE_TARGET(GLOW_INS_HASH),
+		OPCODE_TARGET(GLOW_INS_STR),
+		OPCODE_TARGET(GLOW_INS_TYPE),
+		OPCODE_TARGET(GLOW_INS_NEXT),
+		OPCODE_TARGET(GLOW_INS_SETUP_RANGE),
+		OPCODE_TARGET(GLOW_INS_FOR_RANGE),
+		OPCODE_TARGET(GLOW_INS_RECEIVE_BATCH),
+		OPCODE_TARGET(GLOW_INS_ADD_INT_INT),
+		OPCODE_TARGET(GLOW_INS_SUB_INT_INT),
+		OPCODE_TARGET(GLOW_INS_MUL_INT_INT),
+		OPCODE_TARGET(GLOW_INS_MOD_INT_INT),
+		OPCODE_TARGET(GLOW_INS_EQUAL_INT_INT),
+		OPCODE_TARGET(GLOW_INS_NOTEQ_INT_INT),
+		OPCODE_TARGET(GLOW_INS_LT_INT_INT),
+		OPCODE_TARGET(GLOW_INS_GT_INT_INT),
+		OPCODE_TARGET(GLOW_INS_LE_INT_INT),
+		OPCODE_TARGET(GLOW_INS_GE_INT_INT),
+		OPCODE_TARGET(GLOW_INS_ADD_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_SUB_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_MUL_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_DIV_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_LT_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_GT_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_LE_FLOAT_FLOAT),
+		OPCODE_TARGET(GLOW_INS_GE_FLOAT_FLOAT),
+	};
+#pragma GCC diagnostic pop
+
+#undef OPCODE_TARGET
+
+	_Static_assert(GLOW_INS_GE_FLOAT_FLOAT <= 255, "opcodes must fit in a byte");
+#endif
 
 	head:
 	while (true) {
-		frame->pos = pos;
-
-		while (!EXC_STACK_EMPTY() && (pos < EXC_STACK_TOP()->start || pos > EXC_STACK_TOP()->end)) {
-			EXC_STACK_POP();
-		}
-
-		const byte opcode = GET_BYTE();
+		FETCH();
 
 		switch (opcode) {
-		case GLOW_INS_NOP:
-			break;
-		case GLOW_INS_LOAD_CONST: {
+		TARGET(GLOW_INS_NOP):
+			DISPATCH();
+		TARGET(GLOW_INS_LOAD_CONST): {
 			const unsigned int id = GET_UINT16();
 			v1 = &constants[id];
 			glow_retain(v1);
 			STACK_PUSH(*v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_NULL: {
+		TARGET(GLOW_INS_LOAD_NULL): {
 			STACK_PUSH(glow_makenull());
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_ITER_STOP: {
+		TARGET(GLOW_INS_LOAD_ITER_STOP): {
 			STACK_PUSH(glow_get_iter_stop());
-			break;
+			DISPATCH();
 		}
 		/*
 		 * Q: Why is the error check sandwiched between releasing v2 and
@@ -526,7 +1158,8 @@ void glow_vm_eval_frame(GlowVM *vm)
 		 *    releasing v1 before the error check would lead to an invalid
 		 *    double-release of v1 in the case of an error/exception.
 		 */
-		case GLOW_INS_ADD: {
+		TARGET(GLOW_INS_ADD): {
+			TRY_QUICKEN(GLOW_INS_ADD_INT_INT, GLOW_INS_ADD_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_add(v1, v2);
@@ -538,9 +1171,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SUB: {
+		TARGET(GLOW_INS_SUB): {
+			TRY_QUICKEN(GLOW_INS_SUB_INT_INT, GLOW_INS_SUB_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_sub(v1, v2);
@@ -552,9 +1186,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MUL: {
+		TARGET(GLOW_INS_MUL): {
+			TRY_QUICKEN(GLOW_INS_MUL_INT_INT, GLOW_INS_MUL_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_mul(v1, v2);
@@ -566,9 +1201,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_DIV: {
+		TARGET(GLOW_INS_DIV): {
+			TRY_QUICKEN(0, GLOW_INS_DIV_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_div(v1, v2);
@@ -580,9 +1216,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MOD: {
+		TARGET(GLOW_INS_MOD): {
+			TRY_QUICKEN(GLOW_INS_MOD_INT_INT, 0);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_mod(v1, v2);
@@ -594,9 +1231,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_POW: {
+		TARGET(GLOW_INS_POW): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_pow(v1, v2);
@@ -608,9 +1245,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_BITAND: {
+		TARGET(GLOW_INS_BITAND): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_bitand(v1, v2);
@@ -622,9 +1259,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_BITOR: {
+		TARGET(GLOW_INS_BITOR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_bitor(v1, v2);
@@ -636,9 +1273,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_XOR: {
+		TARGET(GLOW_INS_XOR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_xor(v1, v2);
@@ -650,9 +1287,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_BITNOT: {
+		TARGET(GLOW_INS_BITNOT): {
 			v1 = STACK_TOP();
 			res = glow_op_bitnot(v1);
 
@@ -662,9 +1299,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_release(v1);
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SHIFTL: {
+		TARGET(GLOW_INS_SHIFTL): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_shiftl(v1, v2);
@@ -676,9 +1313,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SHIFTR: {
+		TARGET(GLOW_INS_SHIFTR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_shiftr(v1, v2);
@@ -690,9 +1327,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_AND: {
+		TARGET(GLOW_INS_AND): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_and(v1, v2);
@@ -704,9 +1341,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_OR: {
+		TARGET(GLOW_INS_OR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_or(v1, v2);
@@ -718,9 +1355,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_NOT: {
+		TARGET(GLOW_INS_NOT): {
 			v1 = STACK_TOP();
 			res = glow_op_not(v1);
 
@@ -730,9 +1367,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_EQUAL: {
+		TARGET(GLOW_INS_EQUAL): {
+			TRY_QUICKEN(GLOW_INS_EQUAL_INT_INT, 0);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_eq(v1, v2);
@@ -744,9 +1382,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_NOTEQ: {
+		TARGET(GLOW_INS_NOTEQ): {
+			TRY_QUICKEN(GLOW_INS_NOTEQ_INT_INT, 0);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_neq(v1, v2);
@@ -758,9 +1397,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LT: {
+		TARGET(GLOW_INS_LT): {
+			TRY_QUICKEN(GLOW_INS_LT_INT_INT, GLOW_INS_LT_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_lt(v1, v2);
@@ -772,9 +1412,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_GT: {
+		TARGET(GLOW_INS_GT): {
+			TRY_QUICKEN(GLOW_INS_GT_INT_INT, GLOW_INS_GT_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_gt(v1, v2);
@@ -786,9 +1427,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LE: {
+		TARGET(GLOW_INS_LE): {
+			TRY_QUICKEN(GLOW_INS_LE_INT_INT, GLOW_INS_LE_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_le(v1, v2);
@@ -800,9 +1442,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_GE: {
+		TARGET(GLOW_INS_GE): {
+			TRY_QUICKEN(GLOW_INS_GE_INT_INT, GLOW_INS_GE_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ge(v1, v2);
@@ -814,9 +1457,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_UPLUS: {
+		TARGET(GLOW_INS_UPLUS): {
 			v1 = STACK_TOP();
 			res = glow_op_plus(v1);
 
@@ -826,9 +1469,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_release(v1);
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_UMINUS: {
+		TARGET(GLOW_INS_UMINUS): {
 			v1 = STACK_TOP();
 			res = glow_op_minus(v1);
 
@@ -838,9 +1481,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_release(v1);
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IADD: {
+		TARGET(GLOW_INS_IADD): {
+			TRY_QUICKEN(GLOW_INS_ADD_INT_INT, GLOW_INS_ADD_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_iadd(v1, v2);
@@ -852,9 +1496,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_ISUB: {
+		TARGET(GLOW_INS_ISUB): {
+			TRY_QUICKEN(GLOW_INS_SUB_INT_INT, GLOW_INS_SUB_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_isub(v1, v2);
@@ -866,9 +1511,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IMUL: {
+		TARGET(GLOW_INS_IMUL): {
+			TRY_QUICKEN(GLOW_INS_MUL_INT_INT, GLOW_INS_MUL_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_imul(v1, v2);
@@ -880,9 +1526,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IDIV: {
+		TARGET(GLOW_INS_IDIV): {
+			TRY_QUICKEN(0, GLOW_INS_DIV_FLOAT_FLOAT);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_idiv(v1, v2);
@@ -894,9 +1541,10 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IMOD: {
+		TARGET(GLOW_INS_IMOD): {
+			TRY_QUICKEN(GLOW_INS_MOD_INT_INT, 0);
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_imod(v1, v2);
@@ -908,9 +1556,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IPOW: {
+		TARGET(GLOW_INS_IPOW): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ipow(v1, v2);
@@ -922,9 +1570,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IBITAND: {
+		TARGET(GLOW_INS_IBITAND): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ibitand(v1, v2);
@@ -936,9 +1584,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IBITOR: {
+		TARGET(GLOW_INS_IBITOR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ibitor(v1, v2);
@@ -950,9 +1598,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IXOR: {
+		TARGET(GLOW_INS_IXOR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ixor(v1, v2);
@@ -964,9 +1612,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_ISHIFTL: {
+		TARGET(GLOW_INS_ISHIFTL): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ishiftl(v1, v2);
@@ -978,9 +1626,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_ISHIFTR: {
+		TARGET(GLOW_INS_ISHIFTR): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_ishiftr(v1, v2);
@@ -992,9 +1640,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_RANGE: {
+		TARGET(GLOW_INS_MAKE_RANGE): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_range_make(v1, v2);
@@ -1006,9 +1654,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IN: {
+		TARGET(GLOW_INS_IN): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_in(v1, v2);
@@ -1020,25 +1668,25 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_STORE: {
+		TARGET(GLOW_INS_STORE): {
 			v1 = STACK_POP();
 			const unsigned int id = GET_UINT16();
 			GlowValue old = locals[id];
 			locals[id] = *v1;
 			glow_release(&old);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_STORE_GLOBAL: {
+		TARGET(GLOW_INS_STORE_GLOBAL): {
 			v1 = STACK_POP();
 			const unsigned int id = GET_UINT16();
 			GlowValue old = globals[id];
 			globals[id] = *v1;
 			glow_release(&old);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD: {
+		TARGET(GLOW_INS_LOAD): {
 			const unsigned int id = GET_UINT16();
 			v1 = &locals[id];
 
@@ -1049,9 +1697,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_retain(v1);
 			STACK_PUSH(*v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_GLOBAL: {
+		TARGET(GLOW_INS_LOAD_GLOBAL): {
 			const unsigned int id = GET_UINT16();
 			v1 = &globals[id];
 
@@ -1062,13 +1710,23 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_retain(v1);
 			STACK_PUSH(*v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_ATTR: {
+		TARGET(GLOW_INS_LOAD_ATTR): {
+			const size_t ins = pos - 1;
 			v1 = STACK_TOP();
 			const unsigned int id = GET_UINT16();
 			const char *attr = attrs.array[id].str;
-			res = glow_op_get_attr(v1, attr);
+			GlowClass *class = glow_getclass(v1);
+			unsigned int value;
+
+			if (attr_cache_resolve(co, ins, class, attr, false, &value)) {
+				res = glow_op_get_attr_resolved(v1, class, value, attr);
+			} else if (class == &glow_module_class || class == &glow_builtin_module_class) {
+				res = glow_module_get_attr(v1, &co->attr_keys[id]);
+			} else {
+				res = glow_op_get_attr(v1, attr);
+			}
 
 			if (glow_iserror(&res)) {
 				goto error;
@@ -1076,14 +1734,22 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_release(v1);
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SET_ATTR: {
+		TARGET(GLOW_INS_SET_ATTR): {
+			const size_t ins = pos - 1;
 			v1 = STACK_POP();
 			v2 = STACK_POP();
 			const unsigned int id = GET_UINT16();
 			const char *attr = attrs.array[id].str;
-			res = glow_op_set_attr(v1, attr, v2);
+			GlowClass *class = glow_getclass(v1);
+			unsigned int value;
+
+			if (attr_cache_resolve(co, ins, class, attr, true, &value)) {
+				res = glow_op_set_attr_resolved(v1, class, value, attr, v2);
+			} else {
+				res = glow_op_set_attr(v1, attr, v2);
+			}
 
 			glow_release(v1);
 			glow_release(v2);
@@ -1091,9 +1757,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 				goto error;
 			}
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_INDEX: {
+		TARGET(GLOW_INS_LOAD_INDEX): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_get(v1, v2);
@@ -1105,9 +1771,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SET_INDEX: {
+		TARGET(GLOW_INS_SET_INDEX): {
 			/* X[N] = Y */
 			v3 = STACK_POP();  /* N */
 			v2 = STACK_POP();  /* X */
@@ -1124,9 +1790,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			glow_release(&res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_APPLY: {
+		TARGET(GLOW_INS_APPLY): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_apply(v2, v1);  // yes, the arguments are reversed
@@ -1138,9 +1804,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IAPPLY: {
+		TARGET(GLOW_INS_IAPPLY): {
 			v2 = STACK_POP();
 			v1 = STACK_TOP();
 			res = glow_op_iapply(v1, v2);
@@ -1151,24 +1817,22 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOAD_NAME: {
+		TARGET(GLOW_INS_LOAD_NAME): {
 			const unsigned int id = GET_UINT16();
-			GlowStr *key = &frees[id];
-			res = glow_strdict_get(&builtins_dict, key);
+			res = co->free_values[id];
 
 			if (!glow_isempty(&res)) {
 				glow_retain(&res);
 				STACK_PUSH(res);
-				break;
+				DISPATCH();
 			}
 
-			res = glow_makeerr(glow_err_unbound(key->value));
+			res = glow_makeerr(glow_err_unbound(frees[id].value));
 			goto error;
-			break;
 		}
-		case GLOW_INS_PRINT: {
+		TARGET(GLOW_INS_PRINT): {
 			v1 = STACK_POP();
 
 			/* res will be either an error or empty: */
@@ -1179,55 +1843,58 @@ void glow_vm_eval_frame(GlowVM *vm)
 				goto error;
 			}
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP: {
+		TARGET(GLOW_INS_JMP): {
 			const unsigned int jmp = GET_UINT16();
 			pos += jmp;
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_BACK: {
+		TARGET(GLOW_INS_JMP_BACK): {
 			const unsigned int jmp = GET_UINT16();
 			pos -= jmp;
-			break;
+			BACK_EDGE();
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_IF_TRUE: {
+		TARGET(GLOW_INS_JMP_IF_TRUE): {
 			v1 = STACK_POP();
 			const unsigned int jmp = GET_UINT16();
 			if (glow_resolve_nonzero(glow_getclass(v1))(v1)) {
 				pos += jmp;
 			}
 			glow_release(v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_IF_FALSE: {
+		TARGET(GLOW_INS_JMP_IF_FALSE): {
 			v1 = STACK_POP();
 			const unsigned int jmp = GET_UINT16();
 			if (!glow_resolve_nonzero(glow_getclass(v1))(v1)) {
 				pos += jmp;
 			}
 			glow_release(v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_BACK_IF_TRUE: {
+		TARGET(GLOW_INS_JMP_BACK_IF_TRUE): {
 			v1 = STACK_POP();
 			const unsigned int jmp = GET_UINT16();
 			if (glow_resolve_nonzero(glow_getclass(v1))(v1)) {
 				pos -= jmp;
+				BACK_EDGE();
 			}
 			glow_release(v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_BACK_IF_FALSE: {
+		TARGET(GLOW_INS_JMP_BACK_IF_FALSE): {
 			v1 = STACK_POP();
 			const unsigned int jmp = GET_UINT16();
 			if (!glow_resolve_nonzero(glow_getclass(v1))(v1)) {
 				pos -= jmp;
+				BACK_EDGE();
 			}
 			glow_release(v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_IF_TRUE_ELSE_POP: {
+		TARGET(GLOW_INS_JMP_IF_TRUE_ELSE_POP): {
 			v1 = STACK_TOP();
 			const unsigned int jmp = GET_UINT16();
 			if (glow_resolve_nonzero(glow_getclass(v1))(v1)) {
@@ -1236,9 +1903,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 				STACK_POP();
 				glow_release(v1);
 			}
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_JMP_IF_FALSE_ELSE_POP: {
+		TARGET(GLOW_INS_JMP_IF_FALSE_ELSE_POP): {
 			v1 = STACK_TOP();
 			const unsigned int jmp = GET_UINT16();
 			if (!glow_resolve_nonzero(glow_getclass(v1))(v1)) {
@@ -1247,37 +1914,32 @@ void glow_vm_eval_frame(GlowVM *vm)
 				STACK_POP();
 				glow_release(v1);
 			}
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_CALL: {
+		TARGET(GLOW_INS_CALL): {
 			const unsigned int x = GET_UINT16();
 			const unsigned int nargs = (x & 0xff);
 			const unsigned int nargs_named = (x >> 8);
 			v1 = STACK_POP();
-			res = glow_op_call(v1,
-			                  stack - nargs_named*2 - nargs,
-			                  stack - nargs_named*2,
-			                  nargs,
-			                  nargs_named);
+			GlowValue *args = stack - nargs_named*2 - nargs;
+			GlowValue *args_named = stack - nargs_named*2;
 
-			glow_release(v1);
-			if (glow_iserror(&res)) {
-				goto error;
+			if (glow_getclass(v1) == &glow_fn_class) {
+				CALL_INLINE(v1, args, args_named, nargs, nargs_named);
 			}
 
-			for (unsigned int i = 0; i < nargs_named; i++) {
-				glow_release(STACK_POP());  // value
-				glow_release(STACK_POP());  // name
-			}
+			res = glow_op_call(v1, args, args_named, nargs, nargs_named);
 
-			for (unsigned int i = 0; i < nargs; i++) {
-				glow_release(STACK_POP());
+			glow_release(v1);
+			if (glow_iserror(&res)) {
+				goto error;
 			}
 
+			STACK_POP_ARGS(nargs, nargs_named);
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_RETURN: {
+		TARGET(GLOW_INS_RETURN): {
 			v1 = STACK_POP();
 			glow_retain(v1);
 			glow_frame_reset(frame);
@@ -1285,7 +1947,7 @@ void glow_vm_eval_frame(GlowVM *vm)
 			STACK_PURGE(stack_base);
 			goto done;
 		}
-		case GLOW_INS_THROW: {
+		TARGET(GLOW_INS_THROW): {
 			v1 = STACK_POP();  // exception
 			GlowClass *class = glow_getclass(v1);
 
@@ -1294,29 +1956,16 @@ void glow_vm_eval_frame(GlowVM *vm)
 				goto error;
 			}
 
-			res = *v1;
-			res.type = GLOW_VAL_TYPE_EXC;
+			res = glow_makeexc(glow_objvalue(v1));
 			goto error;
 		}
-		case GLOW_INS_PRODUCE: {
+		TARGET(GLOW_INS_PRODUCE): {
 			v1 = STACK_POP();
 			glow_retain(v1);
-			glow_frame_save_state(frame, pos, *v1, stack, exc_stack);
+			glow_frame_save_state(frame, pos, *v1, stack);
 			goto done;
 		}
-		case GLOW_INS_TRY_BEGIN: {
-			const unsigned int try_block_len = GET_UINT16();
-			const unsigned int handler_offset = GET_UINT16();
-
-			EXC_STACK_PUSH(pos, pos + try_block_len, pos + handler_offset, stack);
-
-			break;
-		}
-		case GLOW_INS_TRY_END: {
-			EXC_STACK_POP();
-			break;
-		}
-		case GLOW_INS_JMP_IF_EXC_MISMATCH: {
+		TARGET(GLOW_INS_JMP_IF_EXC_MISMATCH): {
 			const unsigned int jmp = GET_UINT16();
 
 			v1 = STACK_POP();  // exception type
@@ -1338,9 +1987,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			glow_release(v1);
 			glow_release(v2);
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_LIST: {
+		TARGET(GLOW_INS_MAKE_LIST): {
 			const unsigned int len = GET_UINT16();
 
 			if (len > 0) {
@@ -1351,9 +2000,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			STACK_POPN(len);
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_TUPLE: {
+		TARGET(GLOW_INS_MAKE_TUPLE): {
 			const unsigned int len = GET_UINT16();
 
 			if (len > 0) {
@@ -1364,9 +2013,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			STACK_POPN(len);
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_SET: {
+		TARGET(GLOW_INS_MAKE_SET): {
 			const unsigned int len = GET_UINT16();
 
 			if (len > 0) {
@@ -1382,9 +2031,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_DICT: {
+		TARGET(GLOW_INS_MAKE_DICT): {
 			const unsigned int len = GET_UINT16();
 
 			if (len > 0) {
@@ -1400,9 +2049,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_IMPORT: {
+		TARGET(GLOW_INS_IMPORT): {
 			const unsigned int id = GET_UINT16();
 			res = vm_import(vm, symbols.array[id].str);
 
@@ -1411,9 +2060,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_EXPORT: {
+		TARGET(GLOW_INS_EXPORT): {
 			const unsigned int id = GET_UINT16();
 			v1 = STACK_POP();
 
@@ -1425,9 +2074,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			                     symbols.array[id].str,
 			                     symbols.array[id].length,
 			                     v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_EXPORT_GLOBAL: {
+		TARGET(GLOW_INS_EXPORT_GLOBAL): {
 			const unsigned int id = GET_UINT16();
 			v1 = STACK_POP();
 
@@ -1439,9 +2088,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			                     global_symbols.array[id].str,
 			                     global_symbols.array[id].length,
 			                     v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_EXPORT_NAME: {
+		TARGET(GLOW_INS_EXPORT_NAME): {
 			const unsigned int id = GET_UINT16();
 			v1 = STACK_POP();
 
@@ -1453,9 +2102,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			                     frees[id].value,
 			                     frees[id].len,
 			                     v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_RECEIVE: {
+		TARGET(GLOW_INS_RECEIVE): {
 			/*
 			 * There's an important assumption that this opcode
 			 * will only ever be executed by code running in an
@@ -1478,9 +2127,47 @@ void glow_vm_eval_frame(GlowVM *vm)
 			}
 
 			STACK_PUSH(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_GET_ITER: {
+		TARGET(GLOW_INS_RECEIVE_BATCH): {
+			v1 = STACK_TOP();
+
+			if (!glow_isint(v1)) {
+				GlowClass *class = glow_getclass(v1);
+				res = GLOW_TYPE_EXC("receive count must be an integer (got a %s)", class->name);
+				goto error;
+			}
+
+			const long max = glow_intvalue(v1);
+
+			if (max <= 0) {
+				res = GLOW_ACTOR_EXC("receive count must be positive (got %li)", max);
+				goto error;
+			}
+
+			res = glow_mailbox_pop(mb);
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			GlowMessage *msg = glow_objvalue(&res);
+
+			if (glow_isempty(&msg->contents)) {
+				glow_releaseo(msg);
+				glow_frame_reset(frame);
+				frame->return_value = glow_makenull();
+				STACK_PURGE(stack_base);
+				goto done;
+			}
+
+			/* a kill message ends the batch early, and is taken by the next receive */
+			res = glow_list_make(&res, 1);
+			glow_mailbox_drain(mb, glow_objvalue(&res), (size_t)max - 1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_GET_ITER): {
 			v1 = STACK_TOP();
 			res = glow_op_iter(v1);
 
@@ -1490,12 +2177,22 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			glow_release(v1);
 			STACK_SET_TOP(res);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_LOOP_ITER: {
+		TARGET(GLOW_INS_LOOP_ITER): {
 			v1 = STACK_TOP();
 			const unsigned int jmp = GET_UINT16();
 
+			if (iternext_fast(v1, &res)) {
+				if (glow_isempty(&res)) {
+					pos += jmp;
+				} else {
+					STACK_PUSH(res);
+				}
+
+				DISPATCH();
+			}
+
 			res = glow_op_iternext(v1);
 
 			if (glow_iserror(&res)) {
@@ -1508,16 +2205,18 @@ void glow_vm_eval_frame(GlowVM *vm)
 				STACK_PUSH(res);
 			}
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_FUNCOBJ: {
+		TARGET(GLOW_INS_MAKE_FUNCOBJ): {
 			const unsigned int arg          = GET_UINT16();
 			const unsigned int num_hints    = (arg >> 8);
 			const unsigned int num_defaults = (arg & 0xff);
 			const unsigned int offset = num_defaults + num_hints;
 
 			GlowCodeObject *co = glow_objvalue(stack - offset - 1);
-			res = glow_codeobj_init_hints(co, stack - offset);
+
+			/* lambdas carry no hints */
+			res = glow_codeobj_init_hints(co, (num_hints > 0) ? stack - offset : NULL);
 
 			if (glow_iserror(&res)) {
 				goto error;
@@ -1537,9 +2236,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			STACK_SET_TOP(fn);
 			glow_releaseo(co);
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_GENERATOR: {
+		TARGET(GLOW_INS_MAKE_GENERATOR): {
 			const unsigned int arg          = GET_UINT16();
 			const unsigned int num_hints    = (arg >> 8);
 			const unsigned int num_defaults = (arg & 0xff);
@@ -1566,9 +2265,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 			STACK_SET_TOP(gp);
 			glow_releaseo(co);
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_MAKE_ACTOR: {
+		TARGET(GLOW_INS_MAKE_ACTOR): {
 			const unsigned int arg          = GET_UINT16();
 			const unsigned int num_hints    = (arg >> 8);
 			const unsigned int num_defaults = (arg & 0xff);
@@ -1594,9 +2293,9 @@ void glow_vm_eval_frame(GlowVM *vm)
 
 			STACK_SET_TOP(ap);
 			glow_releaseo(co);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_SEQ_EXPAND: {
+		TARGET(GLOW_INS_SEQ_EXPAND): {
 			const unsigned int n = GET_UINT16();
 			v1 = STACK_POP();
 
@@ -1659,65 +2358,303 @@ void glow_vm_eval_frame(GlowVM *vm)
 				}
 			}
 
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_POP: {
+		TARGET(GLOW_INS_POP): {
 			glow_release(STACK_POP());
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_DUP: {
+		TARGET(GLOW_INS_DUP): {
 			v1 = STACK_TOP();
 			glow_retain(v1);
 			STACK_PUSH(*v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_DUP_TWO: {
+		TARGET(GLOW_INS_DUP_TWO): {
 			v1 = STACK_TOP();
 			v2 = STACK_SECOND();
 			glow_retain(v1);
 			glow_retain(v2);
 			STACK_PUSH(*v2);
 			STACK_PUSH(*v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_ROT: {
+		TARGET(GLOW_INS_ROT): {
 			GlowValue v1 = *STACK_SECOND();
 			STACK_SET_SECOND(*STACK_TOP());
 			STACK_SET_TOP(v1);
-			break;
+			DISPATCH();
 		}
-		case GLOW_INS_ROT_THREE: {
+		TARGET(GLOW_INS_ROT_THREE): {
 			GlowValue v1 = *STACK_TOP();
 			GlowValue v2 = *STACK_SECOND();
 			GlowValue v3 = *STACK_THIRD();
 			STACK_SET_TOP(v2);
 			STACK_SET_SECOND(v3);
 			STACK_SET_THIRD(v1);
-			break;
+			DISPATCH();
 		}
-		default: {
+		TARGET(GLOW_INS_LOAD_METHOD): {
+			/*
+			 * For a plain method, leave the receiver on the stack and push
+			 * the method itself; otherwise replace the receiver with the
+			 * attribute value and push NULL. Either way CALL_METHOD sees
+			 * an empty value carrying the method on top.
+			 */
+			const size_t ins = pos - 1;
+			v1 = STACK_TOP();
+			const unsigned int id = GET_UINT16();
+			const char *attr = attrs.array[id].str;
+			GlowClass *class = glow_getclass(v1);
+			unsigned int value;
+
+			if (attr_cache_resolve(co, ins, class, attr, false, &value)) {
+				if ((value & GLOW_ATTR_DICT_FLAG_FOUND) && (value & GLOW_ATTR_DICT_FLAG_METHOD)) {
+					STACK_PUSH(METHOD_MARKER(&class->methods[value >> 2]));
+					DISPATCH();
+				}
+
+				res = glow_op_get_attr_resolved(v1, class, value, attr);
+			} else if (class == &glow_module_class || class == &glow_builtin_module_class) {
+				res = glow_module_get_attr(v1, &co->attr_keys[id]);
+			} else {
+				res = glow_op_get_attr(v1, attr);
+			}
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			STACK_PUSH(METHOD_MARKER(NULL));
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_CALL_METHOD): {
+			const unsigned int x = GET_UINT16();
+			const unsigned int nargs = (x & 0xff);
+			const unsigned int nargs_named = (x >> 8);
+			const struct glow_attr_method *method = glow_ptrvalue(STACK_POP());
+			v1 = STACK_POP();  // receiver, or callable if `method` is NULL
+			GlowValue *args = stack - nargs_named*2 - nargs;
+			GlowValue *args_named = stack - nargs_named*2;
+
+			if (method != NULL) {
+				res = method->meth(v1, args, args_named, nargs, nargs_named);
+			} else if (glow_getclass(v1) == &glow_fn_class) {
+				CALL_INLINE(v1, args, args_named, nargs, nargs_named);
+			} else {
+				res = glow_op_call(v1, args, args_named, nargs, nargs_named);
+			}
+
+			glow_release(v1);
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			STACK_POP_ARGS(nargs, nargs_named);
+			STACK_PUSH(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_LEN): {
+			v1 = STACK_TOP();
+			GlowClass *class = glow_getclass(v1);
+			GlowUnOp len = glow_resolve_len(class);
+
+			if (!len) {
+				res = glow_type_exc_unsupported_1("len", class);
+				goto error;
+			}
+
+			res = len(v1);
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_HASH): {
+			v1 = STACK_TOP();
+			res = glow_op_hash(v1);
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_STR): {
+			v1 = STACK_TOP();
+			res = glow_op_str(v1);
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_TYPE): {
+			v1 = STACK_TOP();
+			res = glow_makeobj(glow_getclass(v1));
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_NEXT): {
+			v1 = STACK_TOP();
+			res = glow_op_iternext(v1);
+
+			if (glow_iserror(&res)) {
+				goto error;
+			}
+
+			glow_release(v1);
+			STACK_SET_TOP(res);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_SETUP_RANGE): {
+			v2 = STACK_TOP();
+			v1 = STACK_SECOND();
+
+			if (!(glow_isint(v1) && glow_isint(v2))) {
+				res = glow_type_exc_unsupported_2("..", glow_getclass(v1), glow_getclass(v2));
+				goto error;
+			}
+
+			/* descending ranges include their end, so stop one past it */
+			const long from = glow_intvalue(v1);
+			const long to = glow_intvalue(v2);
+			STACK_SET_TOP(glow_makeint((to >= from) ? to : to - 1));
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_FOR_RANGE): {
+			v2 = STACK_TOP();
+			v1 = STACK_SECOND();
+			const unsigned int jmp = GET_UINT16();
+
+			const long i = glow_intvalue(v1);
+			const long end = glow_intvalue(v2);
+
+			if (i == end) {
+				pos += jmp;
+			} else {
+				*v1 = glow_makeint((i < end) ? i + 1 : i - 1);
+				STACK_PUSH(glow_makeint(i));
+			}
+
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_ADD_INT_INT): {
+			QUICK_INT_ARITH(int_add_overflow);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_SUB_INT_INT): {
+			QUICK_INT_ARITH(int_sub_overflow);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_MUL_INT_INT): {
+			QUICK_INT_ARITH(int_mul_overflow);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_MOD_INT_INT): {
+			v2 = STACK_TOP();
+			v1 = STACK_SECOND();
+			if (!glow_isint(v1) || !glow_isint(v2) || glow_intvalue(v2) == 0 ||
+			    (glow_intvalue(v2) == -1 && glow_intvalue(v1) == LONG_MIN)) {
+				DEOPT();
+			}
+			STACK_POP();
+			STACK_SET_TOP(glow_makeint(glow_intvalue(v1) % glow_intvalue(v2)));
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_EQUAL_INT_INT): {
+			QUICK_INT_CMP(glow_makebool, ==);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_NOTEQ_INT_INT): {
+			QUICK_INT_CMP(glow_makebool, !=);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_LT_INT_INT): {
+			QUICK_INT_CMP(glow_makeint, <);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_GT_INT_INT): {
+			QUICK_INT_CMP(glow_makeint, >);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_LE_INT_INT): {
+			QUICK_INT_CMP(glow_makeint, <=);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_GE_INT_INT): {
+			QUICK_INT_CMP(glow_makeint, >=);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_ADD_FLOAT_FLOAT): {
+			QUICK_FLOAT_ARITH(+);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_SUB_FLOAT_FLOAT): {
+			QUICK_FLOAT_ARITH(-);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_MUL_FLOAT_FLOAT): {
+			QUICK_FLOAT_ARITH(*);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_DIV_FLOAT_FLOAT): {
+			QUICK_FLOAT_ARITH(/);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_LT_FLOAT_FLOAT): {
+			QUICK_FLOAT_CMP(<);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_GT_FLOAT_FLOAT): {
+			QUICK_FLOAT_CMP(>);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_LE_FLOAT_FLOAT): {
+			QUICK_FLOAT_CMP(<=);
+			DISPATCH();
+		}
+		TARGET(GLOW_INS_GE_FLOAT_FLOAT): {
+			QUICK_FLOAT_CMP(>=);
+			DISPATCH();
+		}
+		TARGET_DEFAULT: {
 			GLOW_INTERNAL_ERROR();
-			break;
+			DISPATCH();
 		}
 		}
 	}
 
 	error:
-	switch (res.type) {
+	frame->pos = pos;
+	switch (glow_valtype(&res)) {
 	case GLOW_VAL_TYPE_EXC: {
-		if (EXC_STACK_EMPTY()) {
+		const struct glow_exc_handler *handler = find_exc_handler(co, pos);
+
+		if (handler == NULL) {
 			STACK_PURGE(stack_base);
 			glow_retain(&res);
 			GlowException *e = glow_objvalue(&res);
 			glow_exc_traceback_append(e, co->name, get_lineno(frame));
 			glow_frame_reset(frame);
 			frame->return_value = res;
-			return;
+			goto exit_frame;
 		} else {
-			const struct glow_exc_stack_element *exc = EXC_STACK_POP();
-			STACK_PURGE(exc->purge_wall);
+			STACK_PURGE(stack_base + handler->depth);
 			STACK_PUSH(res);
-			pos = exc->handler_pos;
+			pos = handler->handler;
 			goto head;
 		}
 		break;
@@ -1728,7 +2665,7 @@ void glow_vm_eval_frame(GlowVM *vm)
 		glow_frame_reset(frame);
 		STACK_PURGE(stack_base);
 		frame->return_value = res;
-		return;
+		goto exit_frame;
 	}
 	default:
 		GLOW_INTERNAL_ERROR();
@@ -1742,17 +2679,58 @@ void glow_vm_eval_frame(GlowVM *vm)
 		goto error;
 	}
 
+	exit_frame:
+	if (frame->inline_call) {
+		res = frame->return_value;
+		glow_vm_pop_frame(vm);
+		LOAD_FRAME();
+
+		if (glow_iserror(&res)) {
+			goto error;
+		}
+
+		STACK_PUSH(res);
+		DISPATCH();
+	}
+
 	return;
 
 #undef STACK_POP
 #undef STACK_TOP
 #undef STACK_PUSH
+#undef METHOD_MARKER
+#undef LOAD_FRAME
+#undef SAVE_FRAME
+#undef STACK_POP_ARGS
+#undef CALL_INLINE
+#undef FETCH
+#undef TARGET
+#undef DISPATCH
+#undef QUICKEN
+#undef TRY_QUICKEN
+#undef DEOPT
+#undef QUICK_INT_ARITH
+#undef QUICK_INT_CMP
+#undef QUICK_FLOAT_ARITH
+#undef QUICK_FLOAT_CMP
 }
 
+#if GLOW_USE_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
 void glow_vm_register_module(const GlowModule *module)
 {
 	GlowValue v = glow_makeobj((void *)module);
 	glow_strdict_put(&builtin_modules_dict, module->name, &v, false);
+
+	/* the module may bring new classes; re-flatten vtables lazily */
+	glow_class_invalidate_vtables();
+}
+
+GlowValue glow_vm_get_builtin(GlowStr *name)
+{
+	return glow_strdict_get(&builtins_dict, name);
 }
 
 static void vm_load_builtins(void)
@@ -1815,14 +2793,40 @@ static GlowValue vm_import(GlowVM *vm, const char *name)
 	return mod;
 }
 
+/*
+ * Finds the innermost handler covering the instruction that `pos`
+ * points into (as with get_lineno(), `pos` should lie somewhere past
+ * that instruction's opcode byte), or NULL if there isn't one.
+ */
+static const struct glow_exc_handler *find_exc_handler(GlowCodeObject *co, const size_t pos)
+{
+	const struct glow_exc_handler *handlers = co->exc_handlers;
+	const unsigned int n_handlers = co->n_exc_handlers;
+
+	for (unsigned int i = 0; i < n_handlers; i++) {
+		if (handlers[i].start < pos && pos <= handlers[i].end) {
+			return &handlers[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * `frame->pos` is expected to point somewhere past the opcode byte of
+ * the instruction of interest (i.e. within its arguments, or just past
+ * its end), as is the case when an error is raised mid-instruction.
+ */
 static unsigned int get_lineno(GlowFrame *frame)
 {
 	const size_t raw_pos = frame->pos;
 	GlowCodeObject *co = frame->co;
 	struct glow_code_cache *cache = co->cache;
 
-	if (cache[raw_pos].lineno != 0) {
-		return cache[raw_pos].lineno;
+	assert(raw_pos > 0);
+
+	if (cache[raw_pos - 1].lineno != 0) {
+		return cache[raw_pos - 1].lineno;
 	}
 
 	byte *bc = co->bc;
@@ -1834,19 +2838,21 @@ static unsigned int get_lineno(GlowFrame *frame)
 	size_t ins_pos = 0;
 
 	/* translate raw position into actual instruction position */
-	while (p != dest) {
-		++ins_pos;
-		const int size = glow_opcode_arg_size(*p);
+	while (true) {
+		const int size = glow_opcode_arg_size(opcode_load(p));
 
 		if (size < 0) {
 			GLOW_INTERNAL_ERROR();
 		}
 
-		p += size + 1;
+		byte *next = p + size + 1;
 
-		if (p > dest) {
-			GLOW_INTERNAL_ERROR();
+		if (next >= dest) {
+			break;
 		}
+
+		++ins_pos;
+		p = next;
 	}
 
 	unsigned int lineno_offset = 0;
@@ -1869,6 +2875,6 @@ static unsigned int get_lineno(GlowFrame *frame)
 	}
 
 	unsigned int lineno = first_lineno + lineno_offset;
-	cache[raw_pos].lineno = lineno;
+	cache[raw_pos - 1].lineno = lineno;
 	return lineno;
 }
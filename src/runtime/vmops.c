@@ -60,7 +60,7 @@ GlowValue glow_op_str(GlowValue *v)
 
 GlowValue glow_op_print(GlowValue *v, FILE *out)
 {
-	switch (v->type) {
+	switch (glow_valtype(v)) {
 	case GLOW_VAL_TYPE_NULL:
 		fprintf(out, "null\n");
 		break;
@@ -516,9 +516,17 @@ GlowValue glow_op_get_attr(GlowValue *v, const char *attr)
 GlowValue glow_op_get_attr_default(GlowValue *v, const char *attr)
 {
 	GlowClass *class = glow_getclass(v);
-
 	const unsigned int value = glow_attr_dict_get(&class->attr_dict, attr);
+	return glow_op_get_attr_resolved(v, class, value, attr);
+}
 
+/*
+ * `value` is the result of looking up `attr` in the attribute
+ * dictionary of `class`, the class of `v`. The VM's attribute
+ * caches call this directly to skip the lookup.
+ */
+GlowValue glow_op_get_attr_resolved(GlowValue *v, GlowClass *class, const unsigned int value, const char *attr)
+{
 	if (!(value & GLOW_ATTR_DICT_FLAG_FOUND)) {
 		goto get_attr_error_not_found;
 	}
@@ -645,14 +653,21 @@ GlowValue glow_op_set_attr(GlowValue *v, const char *attr, GlowValue *new)
 GlowValue glow_op_set_attr_default(GlowValue *v, const char *attr, GlowValue *new)
 {
 	GlowClass *v_class = glow_getclass(v);
+	const unsigned int value = glow_attr_dict_get(&v_class->attr_dict, attr);
+	return glow_op_set_attr_resolved(v, v_class, value, attr, new);
+}
+
+/*
+ * Analogous to glow_op_get_attr_resolved().
+ */
+GlowValue glow_op_set_attr_resolved(GlowValue *v, GlowClass *v_class, const unsigned int value, const char *attr, GlowValue *new)
+{
 	GlowClass *new_class = glow_getclass(new);
 
 	if (!glow_isobject(v)) {
 		goto set_attr_error_not_found;
 	}
 
-	const unsigned int value = glow_attr_dict_get(&v_class->attr_dict, attr);
-
 	if (!(value & GLOW_ATTR_DICT_FLAG_FOUND)) {
 		goto set_attr_error_not_found;
 	}
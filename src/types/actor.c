@@ -1,80 +1,394 @@
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <time.h>
-#include <sys/time.h>
-#include <errno.h>
 #include <pthread.h>
-#include <unistd.h>
 #include "object.h"
 #include "exc.h"
 #include "util.h"
+#include "gc.h"
+#include "strobject.h"
+#include "nativefunc.h"
+#include "scheduler.h"
 #include "actor.h"
 
-static struct glow_mailbox_node *make_node(GlowValue *v)
+#define MESSAGE_OF(n) ((GlowMessage *)((char *)(n) - offsetof(GlowMessage, node)))
+
+void glow_mailbox_init(struct glow_mailbox *mb)
 {
-	struct glow_mailbox_node *node = glow_malloc(sizeof(struct glow_mailbox_node));
-	glow_retain(v);
-	node->value = *v;
-	node->next = NULL;
-	return node;
+	atomic_init(&mb->stub.next, NULL);
+	atomic_init(&mb->head, &mb->stub);
+	mb->tail = &mb->stub;
+	atomic_init(&mb->waiting, false);
+
+	GLOW_SAFE(pthread_mutex_init(&mb->mutex, NULL));
+	glow_sched_cond_init(&mb->cond);
+
+	mb->capacity = 0;
+	mb->policy = GLOW_MAILBOX_BLOCK;
+	atomic_init(&mb->pushed, 0);
+	atomic_init(&mb->popped, 0);
+	atomic_init(&mb->high_water, 0);
+	atomic_init(&mb->blocked, 0);
+	glow_sched_cond_init(&mb->not_full);
 }
 
-void glow_mailbox_init(struct glow_mailbox *mb)
+void glow_mailbox_set_capacity(struct glow_mailbox *mb, const size_t capacity, const enum glow_mailbox_policy policy)
+{
+	mb->capacity = capacity;
+	mb->policy = policy;
+}
+
+/* whether senders may pop too, in which case the mutex guards `tail` */
+static inline bool mailbox_tail_shared(struct glow_mailbox *mb)
+{
+	return mb->capacity > 0 && mb->policy == GLOW_MAILBOX_DROP_OLDEST;
+}
+
+/* `first` through `last` must already be chained together */
+static void mailbox_link_chain(struct glow_mailbox *mb,
+                               struct glow_mailbox_node *first,
+                               struct glow_mailbox_node *last)
+{
+	atomic_store_explicit(&last->next, NULL, memory_order_relaxed);
+	struct glow_mailbox_node *prev = atomic_exchange_explicit(&mb->head, last, memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, first, memory_order_release);
+}
+
+static void mailbox_link(struct glow_mailbox *mb, struct glow_mailbox_node *node)
+{
+	mailbox_link_chain(mb, node, node);
+}
+
+/*
+ * Returns NULL if the mailbox is empty, or if a push is only half done
+ * (its sender will wake us once it's through, should we wait).
+ */
+static struct glow_mailbox_node *mailbox_take(struct glow_mailbox *mb)
+{
+	struct glow_mailbox_node *tail = mb->tail;
+	struct glow_mailbox_node *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	if (tail == &mb->stub) {
+		if (next == NULL) {
+			return NULL;
+		}
+
+		mb->tail = next;
+		tail = next;
+		next = atomic_load_explicit(&next->next, memory_order_acquire);
+	}
+
+	if (next != NULL) {
+		mb->tail = next;
+		return tail;
+	}
+
+	if (tail != atomic_load_explicit(&mb->head, memory_order_acquire)) {
+		return NULL;
+	}
+
+	/* `tail` is the last node; put the stub behind it so it can be taken */
+	mailbox_link(mb, &mb->stub);
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	if (next != NULL) {
+		mb->tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+/* a node just taken is still linked to whatever follows it */
+static inline void mailbox_untake(struct glow_mailbox *mb, struct glow_mailbox_node *node)
 {
-	static GlowValue empty = GLOW_MAKE_EMPTY();
-	struct glow_mailbox_node *node = make_node(&empty);
-	mb->head = node;
 	mb->tail = node;
+}
 
-	GLOW_SAFE(pthread_mutex_init(&mb->mutex, NULL));
-	GLOW_SAFE(pthread_cond_init(&mb->cond, NULL));
+/* the two counters may be read out of step */
+static inline size_t depth_of(const size_t pushed, const size_t popped)
+{
+	return (pushed > popped) ? pushed - popped : 0;
+}
+
+static inline size_t mailbox_depth(struct glow_mailbox *mb, const memory_order order)
+{
+	const size_t popped = atomic_load_explicit(&mb->popped, order);
+	return depth_of(atomic_load_explicit(&mb->pushed, order), popped);
+}
+
+/*
+ * Depth only grows between pops, so sampling it as messages are taken
+ * catches every peak but the current one.
+ */
+static void mailbox_note_depth(struct glow_mailbox *mb, const size_t depth)
+{
+	size_t high = atomic_load_explicit(&mb->high_water, memory_order_relaxed);
+	while (depth > high &&
+	       !atomic_compare_exchange_weak_explicit(&mb->high_water, &high, depth,
+	                                              memory_order_relaxed, memory_order_relaxed));
+}
+
+/* a batch bigger than the whole mailbox only goes into an empty one */
+static bool mailbox_try_reserve(struct glow_mailbox *mb, const size_t n)
+{
+	size_t pushed = atomic_load(&mb->pushed);
+
+	do {
+		/* pairs with the update in mailbox_release() */
+		const size_t depth = depth_of(pushed, atomic_load(&mb->popped));
+
+		if (depth > 0 && depth + n > mb->capacity) {
+			return false;
+		}
+	} while (!atomic_compare_exchange_weak(&mb->pushed, &pushed, pushed + n));
+
+	return true;
+}
+
+static void future_finish(GlowFutureObject *future, GlowValue *v);
+
+static void mailbox_evict(GlowMessage *msg)
+{
+	if (msg->future != NULL) {
+		future_finish(msg->future, NULL);
+	}
+
+	glow_releaseo(msg);
+}
+
+/* makes room for `n` more messages according to the mailbox's policy */
+static bool mailbox_reserve(struct glow_mailbox *mb, const size_t n)
+{
+	if (mb->capacity == 0) {
+		atomic_fetch_add_explicit(&mb->pushed, n, memory_order_relaxed);
+		return true;
+	}
+
+	switch (mb->policy) {
+	case GLOW_MAILBOX_BLOCK:
+		if (!mailbox_try_reserve(mb, n)) {
+			GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
+			atomic_fetch_add(&mb->blocked, 1);
+
+			while (!mailbox_try_reserve(mb, n)) {
+				glow_sched_cond_wait(&mb->not_full, &mb->mutex);
+			}
+
+			atomic_fetch_sub(&mb->blocked, 1);
+			GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
+		}
+		return true;
+	case GLOW_MAILBOX_FAIL:
+		return mailbox_try_reserve(mb, n);
+	case GLOW_MAILBOX_DROP_OLDEST: {
+		atomic_fetch_add_explicit(&mb->pushed, n, memory_order_relaxed);
+		const size_t depth = mailbox_depth(mb, memory_order_relaxed);
+
+		if (depth > mb->capacity) {
+			GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
+			for (size_t excess = depth - mb->capacity; excess > 0; excess--) {
+				struct glow_mailbox_node *node = mailbox_take(mb);
+
+				if (node == NULL) {
+					break;
+				}
+
+				GlowMessage *msg = MESSAGE_OF(node);
+
+				/* kill messages always get through */
+				if (glow_isempty(&msg->contents)) {
+					mailbox_untake(mb, node);
+					break;
+				}
+
+				mailbox_evict(msg);
+				atomic_fetch_add_explicit(&mb->popped, 1, memory_order_relaxed);
+			}
+			GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
+		}
+
+		return true;
+	}
+	}
+
+	GLOW_INTERNAL_ERROR();
+	return false;
+}
+
+/* called by the actor once it has taken `n` messages */
+static void mailbox_release(struct glow_mailbox *mb, const size_t n)
+{
+	mailbox_note_depth(mb, mailbox_depth(mb, memory_order_relaxed));
+
+	if (mailbox_tail_shared(mb)) {
+		atomic_fetch_add_explicit(&mb->popped, n, memory_order_relaxed);
+		return;
+	}
+
+	/* otherwise only the actor itself moves `popped` */
+	const size_t popped = atomic_load_explicit(&mb->popped, memory_order_relaxed) + n;
+
+	if (mb->capacity == 0 || mb->policy != GLOW_MAILBOX_BLOCK) {
+		atomic_store_explicit(&mb->popped, popped, memory_order_relaxed);
+		return;
+	}
+
+	atomic_store(&mb->popped, popped);
+
+	if (atomic_load(&mb->blocked) > 0) {
+		GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
+		glow_sched_cond_broadcast(&mb->not_full);
+		GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
+	}
 }
 
-void glow_mailbox_push(struct glow_mailbox *mb, GlowValue *v)
+static void mailbox_notify(struct glow_mailbox *mb)
 {
-	struct glow_mailbox_node *node = make_node(v);
-	GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
-	GLOW_SAFE(pthread_cond_signal(&mb->cond));
-	struct glow_mailbox_node *prev = mb->head;
-	mb->head = node;
-	prev->next = node;
-	GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
+	/* pairs with the fence in glow_mailbox_pop() */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load_explicit(&mb->waiting, memory_order_relaxed)) {
+		GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
+		glow_sched_cond_broadcast(&mb->cond);
+		GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
+	}
+}
+
+bool glow_mailbox_push(struct glow_mailbox *mb, GlowValue *v)
+{
+	GlowMessage *msg = glow_objvalue(v);
+
+	/* kill messages always get through */
+	if (glow_isempty(&msg->contents)) {
+		atomic_fetch_add_explicit(&mb->pushed, 1, memory_order_relaxed);
+	} else if (!mailbox_reserve(mb, 1)) {
+		return false;
+	}
+
+	glow_share(v);
+	glow_refcnt_merge_pending();
+	glow_retain(v);
+	mailbox_link(mb, &msg->node);
+	mailbox_notify(mb);
+	return true;
+}
+
+/* `msgs` must be Messages; they're queued in order, with a single exchange */
+bool glow_mailbox_push_batch(struct glow_mailbox *mb, GlowValue *msgs, const size_t n)
+{
+	if (n == 0) {
+		return true;
+	}
+
+	if (!mailbox_reserve(mb, n)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		glow_share(&msgs[i]);
+	}
+
+	glow_refcnt_merge_pending();
+
+	GlowMessage *first = glow_objvalue(&msgs[0]);
+	GlowMessage *last = first;
+	glow_retaino(first);
+
+	for (size_t i = 1; i < n; i++) {
+		GlowMessage *msg = glow_objvalue(&msgs[i]);
+		glow_retaino(msg);
+		atomic_store_explicit(&last->node.next, &msg->node, memory_order_relaxed);
+		last = msg;
+	}
+
+	mailbox_link_chain(mb, &first->node, &last->node);
+	mailbox_notify(mb);
+	return true;
 }
 
 GlowValue glow_mailbox_pop(struct glow_mailbox *mb)
 {
-	struct glow_mailbox_node *tail = mb->tail;
-	struct glow_mailbox_node *next = tail->next;
+	glow_refcnt_merge_pending();
+	struct glow_mailbox_node *node = mailbox_tail_shared(mb) ? NULL : mailbox_take(mb);
 
-	if (next == NULL) {
+	if (node == NULL) {
 		GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
-		while (mb->tail->next == NULL) {
-			GLOW_SAFE(pthread_cond_wait(&mb->cond, &mb->mutex));
+		atomic_store_explicit(&mb->waiting, true, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		while ((node = mailbox_take(mb)) == NULL) {
+			glow_sched_cond_wait(&mb->cond, &mb->mutex);
 		}
-		GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
 
-		tail = mb->tail;
-		next = tail->next;
+		atomic_store_explicit(&mb->waiting, false, memory_order_relaxed);
+		GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
 	}
 
-	mb->tail = next;
-	free(tail);
-	return next->value;
+	mailbox_release(mb, 1);
+	return glow_makeobj(MESSAGE_OF(node));
 }
 
 GlowValue glow_mailbox_pop_nowait(struct glow_mailbox *mb)
 {
-	struct glow_mailbox_node *tail = mb->tail;
-	struct glow_mailbox_node *next = tail->next;
+	struct glow_mailbox_node *node = mailbox_take(mb);
+	return (node != NULL) ? glow_makeobj(MESSAGE_OF(node)) : glow_makeempty();
+}
 
-	if (next != NULL) {
-		mb->tail = next;
-		free(tail);
-		return next->value;
+/*
+ * Appends up to `max` messages that are already queued to `list`,
+ * without waiting. A kill message is left for the next receive.
+ */
+void glow_mailbox_drain(struct glow_mailbox *mb, GlowListObject *list, size_t max)
+{
+	const bool shared = mailbox_tail_shared(mb);
+	size_t taken = 0;
+
+	if (shared) {
+		GLOW_SAFE(pthread_mutex_lock(&mb->mutex));
+	}
+
+	while (taken < max) {
+		struct glow_mailbox_node *node = mailbox_take(mb);
+
+		if (node == NULL) {
+			break;
+		}
+
+		GlowMessage *msg = MESSAGE_OF(node);
+
+		if (glow_isempty(&msg->contents)) {
+			mailbox_untake(mb, node);
+			break;
+		}
+
+		GlowValue v = glow_makeobj(msg);
+		glow_list_append(list, &v);
+		glow_releaseo(msg);
+		++taken;
+	}
+
+	if (shared) {
+		GLOW_SAFE(pthread_mutex_unlock(&mb->mutex));
 	}
 
-	return glow_makeempty();
+	if (taken > 0) {
+		mailbox_release(mb, taken);
+	}
+}
+
+size_t glow_mailbox_depth(struct glow_mailbox *mb)
+{
+	return mailbox_depth(mb, memory_order_relaxed);
+}
+
+size_t glow_mailbox_high_water(struct glow_mailbox *mb)
+{
+	mailbox_note_depth(mb, mailbox_depth(mb, memory_order_relaxed));
+	return atomic_load_explicit(&mb->high_water, memory_order_relaxed);
 }
 
 void glow_mailbox_dealloc(struct glow_mailbox *mb)
@@ -87,12 +401,11 @@ void glow_mailbox_dealloc(struct glow_mailbox *mb)
 		glow_release(&v);
 	}
 
-	free(mb->head);
-	mb->head = NULL;
 	mb->tail = NULL;
 
 	GLOW_SAFE(pthread_mutex_destroy(&mb->mutex));
-	GLOW_SAFE(pthread_cond_destroy(&mb->cond));
+	glow_sched_cond_destroy(&mb->cond);
+	glow_sched_cond_destroy(&mb->not_full);
 }
 
 GlowValue glow_actor_proxy_make(GlowCodeObject *co)
@@ -101,6 +414,7 @@ GlowValue glow_actor_proxy_make(GlowCodeObject *co)
 	glow_retaino(co);
 	ap->co = co;
 	ap->defaults = (struct glow_value_array){.array = NULL, .length = 0};
+	glow_gc_track(ap);
 	return glow_makeobj(ap);
 }
 
@@ -118,6 +432,7 @@ static void actor_link(GlowActorObject *ao)
 
 	ao->next = actors;
 	ao->prev = NULL;
+	ao->linked = true;
 	actors = ao;
 	GLOW_SAFE(pthread_mutex_unlock(&link_mutex));
 }
@@ -125,7 +440,14 @@ static void actor_link(GlowActorObject *ao)
 static void actor_unlink(GlowActorObject *ao)
 {
 	GLOW_SAFE(pthread_mutex_lock(&link_mutex));
-	glow_releaseo(ao);
+
+	/* several joiners may get here */
+	if (!ao->linked) {
+		GLOW_SAFE(pthread_mutex_unlock(&link_mutex));
+		return;
+	}
+
+	ao->linked = false;
 
 	if (actors == ao) {
 		actors = ao->next;
@@ -139,6 +461,17 @@ static void actor_unlink(GlowActorObject *ao)
 		ao->next->prev = ao->prev;
 	}
 	GLOW_SAFE(pthread_mutex_unlock(&link_mutex));
+	glow_releaseo(ao);
+}
+
+/* blocks (or parks, in an actor) until the started actor `ao` finishes */
+static void actor_wait(GlowActorObject *ao)
+{
+	GLOW_SAFE(pthread_mutex_lock(&ao->mutex));
+	while (ao->state != GLOW_ACTOR_STATE_FINISHED) {
+		glow_sched_cond_wait(&ao->finished, &ao->mutex);
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&ao->mutex));
 }
 
 void glow_actor_join_all(void)
@@ -149,14 +482,19 @@ void glow_actor_join_all(void)
 		GLOW_SAFE(pthread_mutex_unlock(&link_mutex));
 
 		if (ao != NULL) {
-			GLOW_SAFE(pthread_join(ao->thread, NULL));
+			actor_wait(ao);
 			actor_unlink(ao);
 		} else {
 			break;
 		}
 	}
+
+	glow_sched_shutdown();
 }
 
+static void actor_run(struct glow_task *task);
+static void actor_finish(struct glow_task *task);
+
 GlowValue glow_actor_make(GlowActorProxy *gp)
 {
 	GlowActorObject *ao = glow_obj_alloc(&glow_actor_class);
@@ -177,6 +515,11 @@ GlowValue glow_actor_make(GlowActorProxy *gp)
 	ao->state = GLOW_ACTOR_STATE_READY;
 	ao->next = NULL;
 	ao->prev = NULL;
+	ao->linked = false;
+	glow_sched_task_init(&ao->task, actor_run, actor_finish);
+	GLOW_SAFE(pthread_mutex_init(&ao->mutex, NULL));
+	glow_sched_cond_init(&ao->finished);
+	glow_gc_track(ao);
 	return glow_makeobj(ao);
 }
 
@@ -195,16 +538,18 @@ static void actor_free(GlowValue *this)
 	GlowActorObject *ao = glow_objvalue(this);
 
 	if (ao->state == GLOW_ACTOR_STATE_RUNNING) {
-		GLOW_SAFE(pthread_join(ao->thread, NULL));
+		actor_wait(ao);
 		actor_unlink(ao);
 	}
 
 	glow_mailbox_dealloc(&ao->mailbox);
+	GLOW_SAFE(pthread_mutex_destroy(&ao->mutex));
+	glow_sched_cond_destroy(&ao->finished);
 	glow_releaseo(ao->co);
 	glow_frame_free(ao->frame);
 	glow_vm_free(ao->vm);
 
-	if (ao->retval.type == GLOW_VAL_TYPE_ERROR) {
+	if (glow_valtype(&ao->retval) == GLOW_VAL_TYPE_ERROR) {
 		glow_err_free(glow_errvalue(&ao->retval));
 	} else {
 		glow_release(&ao->retval);
@@ -241,6 +586,44 @@ static void release_defaults(GlowActorProxy *ap)
 	ap->defaults = (struct glow_value_array){.array = NULL, .length = 0};
 }
 
+static void actor_proxy_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowActorProxy *ap = glow_objvalue(this);
+	const size_t n_defaults = ap->defaults.length;
+
+	for (size_t i = 0; i < n_defaults; i++) {
+		visit(&ap->defaults.array[i], arg);
+	}
+}
+
+static void actor_proxy_clear(GlowValue *this)
+{
+	release_defaults(glow_objvalue(this));
+}
+
+/* actors are untracked once started, so only arguments are looked at */
+static void actor_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowActorObject *ao = glow_objvalue(this);
+	GlowFrame *frame = ao->frame;
+
+	for (size_t i = 0; i < frame->n_locals; i++) {
+		visit(&frame->locals[i], arg);
+	}
+}
+
+static void actor_clear(GlowValue *this)
+{
+	GlowActorObject *ao = glow_objvalue(this);
+	GlowFrame *frame = ao->frame;
+
+	for (size_t i = 0; i < frame->n_locals; i++) {
+		GlowValue v = frame->locals[i];
+		frame->locals[i] = glow_makeempty();
+		glow_release(&v);
+	}
+}
+
 static GlowValue actor_proxy_call(GlowValue *this,
                                  GlowValue *args,
                                  GlowValue *args_named,
@@ -268,9 +651,11 @@ static GlowValue actor_proxy_call(GlowValue *this,
 	return glow_makeobj(go);
 }
 
-static void *actor_start_routine(void *args)
+#define ACTOR_OF(task) ((GlowActorObject *)((char *)(task) - offsetof(GlowActorObject, task)))
+
+static void actor_run(struct glow_task *task)
 {
-	GlowActorObject *ao = args;
+	GlowActorObject *ao = ACTOR_OF(task);
 	GlowCodeObject *co = ao->co;
 	GlowFrame *frame = ao->frame;
 	GlowVM *vm = ao->vm;
@@ -282,13 +667,22 @@ static void *actor_start_routine(void *args)
 	glow_vm_push_frame_direct(vm, frame);
 	glow_vm_eval_frame(vm);
 	ao->retval = frame->return_value;
+	glow_share(&ao->retval);
 	glow_vm_pop_frame(vm);
 
 	ao->frame = NULL;
 	glow_frame_free(frame);
+}
 
+/* runs on the worker once the actor's stack is gone; joiners may free `ao` after this */
+static void actor_finish(struct glow_task *task)
+{
+	GlowActorObject *ao = ACTOR_OF(task);
+
+	GLOW_SAFE(pthread_mutex_lock(&ao->mutex));
 	ao->state = GLOW_ACTOR_STATE_FINISHED;
-	return NULL;
+	glow_sched_cond_broadcast(&ao->finished);
+	GLOW_SAFE(pthread_mutex_unlock(&ao->mutex));
 }
 
 GlowValue glow_actor_start(GlowActorObject *ao)
@@ -297,25 +691,48 @@ GlowValue glow_actor_start(GlowActorObject *ao)
 		return GLOW_ACTOR_EXC("cannot restart stopped actor");
 	}
 
+	/* the actor's thread writes to it from now on; actor_link() keeps it alive */
+	glow_gc_untrack(ao);
+
+	/* arguments are handed over to the actor's thread */
+	GlowFrame *frame = ao->frame;
+	for (size_t i = 0; i < frame->n_locals; i++) {
+		glow_share(&frame->locals[i]);
+	}
+
 	actor_link(ao);
+	GLOW_SAFE(pthread_mutex_lock(&ao->mutex));
 	ao->state = GLOW_ACTOR_STATE_RUNNING;
-	if (pthread_create(&ao->thread, NULL, actor_start_routine, ao)) {
-		actor_unlink(ao);
-		ao->state = GLOW_ACTOR_STATE_FINISHED;
-		return GLOW_ACTOR_EXC("could not spawn thread for actor");
+	GLOW_SAFE(pthread_mutex_unlock(&ao->mutex));
+	glow_sched_spawn(&ao->task);
+	return glow_makenull();
+}
+
+/* the actor may reply (and drop the message) as soon as it's pushed */
+static GlowValue outgoing_message_make(GlowValue *contents, const bool with_future)
+{
+	GlowValue msg_v = glow_message_make(contents, with_future);
+	GlowMessage *msg = glow_objvalue(&msg_v);
+	glow_share(&msg->contents);
+
+	if (with_future) {
+		glow_retaino(msg->future);
+		glow_shareo(msg->future);
 	}
 
-	return glow_makenull();
+	return msg_v;
 }
 
 #define STATE_CHECK_NOT_FINISHED(ao) \
 	if ((ao)->state == GLOW_ACTOR_STATE_FINISHED) \
 		return GLOW_ACTOR_EXC("actor has been stopped")
 
+#define MAILBOX_FULL_EXC() GLOW_ACTOR_EXC("mailbox is full")
+
 #define RETURN_RETVAL(ao) \
 	do { \
 		GlowValue _temp = ao->retval; \
-		if (ao->retval.type == GLOW_VAL_TYPE_ERROR) \
+		if (glow_valtype(&ao->retval) == GLOW_VAL_TYPE_ERROR) \
 			ao->retval = glow_makeempty(); \
 		else \
 			glow_retain(&_temp); \
@@ -381,7 +798,7 @@ static GlowValue actor_join(GlowValue *this,
 	GlowActorObject *ao = glow_objvalue(this);
 
 	if (ao->state != GLOW_ACTOR_STATE_READY) {
-		GLOW_SAFE(pthread_join(ao->thread, NULL));
+		actor_wait(ao);
 		actor_unlink(ao);
 		RETURN_RETVAL(ao);
 	} else {
@@ -405,17 +822,101 @@ static GlowValue actor_send(GlowValue *this,
 
 	GlowActorObject *ao = glow_objvalue(this);
 	STATE_CHECK_NOT_FINISHED(ao);
-	GlowValue msg_v = glow_message_make(&args[0]);
+	GlowValue msg_v = outgoing_message_make(&args[0], true);
 	GlowMessage *msg = glow_objvalue(&msg_v);
-	glow_mailbox_push(&ao->mailbox, &msg_v);
 	GlowFutureObject *future = msg->future;
-	glow_retaino(future);
+	const bool sent = glow_mailbox_push(&ao->mailbox, &msg_v);
 	glow_releaseo(msg);
+
+	if (!sent) {
+		glow_releaseo(future);
+		return MAILBOX_FULL_EXC();
+	}
+
 	return glow_makeobj(future);
 
 #undef NAME
 }
 
+static GlowValue actor_tell(GlowValue *this,
+                           GlowValue *args,
+                           GlowValue *args_named,
+                           size_t nargs,
+                           size_t nargs_named)
+{
+#define NAME "tell"
+
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	GlowActorObject *ao = glow_objvalue(this);
+	STATE_CHECK_NOT_FINISHED(ao);
+	GlowValue msg_v = outgoing_message_make(&args[0], false);
+	const bool sent = glow_mailbox_push(&ao->mailbox, &msg_v);
+	glow_release(&msg_v);
+	return sent ? glow_makenull() : MAILBOX_FULL_EXC();
+
+#undef NAME
+}
+
+static GlowValue actor_send_batch(GlowValue *this,
+                                 GlowValue *args,
+                                 GlowValue *args_named,
+                                 size_t nargs,
+                                 size_t nargs_named)
+{
+#define NAME "send_batch"
+
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	if (!glow_is_a(&args[0], &glow_list_class)) {
+		GlowClass *class = glow_getclass(&args[0]);
+		return GLOW_TYPE_EXC(NAME "() takes a list argument (got a %s)", class->name);
+	}
+
+	GlowActorObject *ao = glow_objvalue(this);
+	STATE_CHECK_NOT_FINISHED(ao);
+
+	GlowListObject *list = glow_objvalue(&args[0]);
+	GLOW_ENTER(list);
+	const size_t count = list->count;
+	GlowValue *msgs = glow_malloc(count * sizeof(GlowValue));
+	GlowValue *futures = glow_malloc(count * sizeof(GlowValue));
+
+	for (size_t i = 0; i < count; i++) {
+		msgs[i] = outgoing_message_make(&list->elements[i], true);
+		GlowMessage *msg = glow_objvalue(&msgs[i]);
+		futures[i] = glow_makeobj(msg->future);
+	}
+	GLOW_EXIT(list);
+
+	const bool sent = glow_mailbox_push_batch(&ao->mailbox, msgs, count);
+
+	for (size_t i = 0; i < count; i++) {
+		glow_release(&msgs[i]);
+	}
+
+	free(msgs);
+
+	if (!sent) {
+		for (size_t i = 0; i < count; i++) {
+			glow_release(&futures[i]);
+		}
+
+		free(futures);
+		return MAILBOX_FULL_EXC();
+	}
+
+	GlowValue res = glow_list_make(futures, count);
+	free(futures);
+	return res;
+
+#undef NAME
+}
+
 static GlowValue actor_stop(GlowValue *this,
                            GlowValue *args,
                            GlowValue *args_named,
@@ -441,56 +942,341 @@ static GlowValue actor_stop(GlowValue *this,
 #undef NAME
 }
 
+static GlowValue actor_capacity(GlowValue *this,
+                               GlowValue *args,
+                               GlowValue *args_named,
+                               size_t nargs,
+                               size_t nargs_named)
+{
+#define NAME "capacity"
+
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK_BETWEEN(NAME, nargs, 1, 2);
+
+	GlowActorObject *ao = glow_objvalue(this);
+
+	if (!glow_isint(&args[0])) {
+		GlowClass *class = glow_getclass(&args[0]);
+		return GLOW_TYPE_EXC(NAME "() takes an integer capacity (got a %s)", class->name);
+	}
+
+	const long capacity = glow_intvalue(&args[0]);
+
+	if (capacity <= 0) {
+		return GLOW_ACTOR_EXC(NAME "() takes a positive capacity (got %li)", capacity);
+	}
+
+	enum glow_mailbox_policy policy = GLOW_MAILBOX_BLOCK;
+
+	if (nargs > 1) {
+		if (!glow_is_a(&args[1], &glow_str_class)) {
+			GlowClass *class = glow_getclass(&args[1]);
+			return GLOW_TYPE_EXC(NAME "() takes a string policy (got a %s)", class->name);
+		}
+
+		const char *name = ((GlowStrObject *)glow_objvalue(&args[1]))->str.value;
+
+		if (strcmp(name, "block") == 0) {
+			policy = GLOW_MAILBOX_BLOCK;
+		} else if (strcmp(name, "fail") == 0) {
+			policy = GLOW_MAILBOX_FAIL;
+		} else if (strcmp(name, "drop_oldest") == 0) {
+			policy = GLOW_MAILBOX_DROP_OLDEST;
+		} else {
+			return GLOW_TYPE_EXC(NAME "() got an unknown policy '%s'", name);
+		}
+	}
+
+	/* the actor's thread reads the bound unguarded once started */
+	GLOW_SAFE(pthread_mutex_lock(&ao->mutex));
+	const bool started = (ao->state != GLOW_ACTOR_STATE_READY);
+
+	if (!started) {
+		glow_mailbox_set_capacity(&ao->mailbox, (size_t)capacity, policy);
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&ao->mutex));
+
+	if (started) {
+		return GLOW_ACTOR_EXC("cannot bound the mailbox of a started actor");
+	}
+
+	return glow_makenull();
+
+#undef NAME
+}
+
+static GlowValue actor_depth(GlowValue *this,
+                            GlowValue *args,
+                            GlowValue *args_named,
+                            size_t nargs,
+                            size_t nargs_named)
+{
+#define NAME "depth"
+
+	GLOW_UNUSED(args);
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 0);
+
+	GlowActorObject *ao = glow_objvalue(this);
+	return glow_makeint(glow_mailbox_depth(&ao->mailbox));
+
+#undef NAME
+}
+
+static GlowValue actor_high_water(GlowValue *this,
+                                 GlowValue *args,
+                                 GlowValue *args_named,
+                                 size_t nargs,
+                                 size_t nargs_named)
+{
+#define NAME "high_water"
+
+	GLOW_UNUSED(args);
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 0);
+
+	GlowActorObject *ao = glow_objvalue(this);
+	return glow_makeint(glow_mailbox_high_water(&ao->mailbox));
+
+#undef NAME
+}
+
 struct glow_attr_method actor_methods[] = {
 	{"start", actor_start},
 	{"check", actor_check},
 	{"join", actor_join},
 	{"send", actor_send},
+	{"tell", actor_tell},
+	{"send_batch", actor_send_batch},
 	{"stop", actor_stop},
+	{"capacity", actor_capacity},
+	{"depth", actor_depth},
+	{"high_water", actor_high_water},
 	{NULL, NULL}
 };
 
 
 /* messages and futures */
 
+/*
+ * A future's state word says whether it is pending, done or dropped
+ * and, while it's pending, has a bit set for each wait-table bucket
+ * someone waiting on it sleeps in. Waiters always sleep in their own
+ * bucket, so waiting on any number of futures is a single park, and
+ * finishing a future nobody waits on is a single exchange.
+ */
+#define FUTURE_PENDING      UINT64_C(0)
+#define FUTURE_DONE         UINT64_C(1)
+#define FUTURE_DROPPED      UINT64_C(2)
+#define FUTURE_STATUS_MASK  UINT64_C(3)
+#define FUTURE_WAIT_BUCKETS 62
+
+#define FUTURE_BUCKET_BIT(i) (UINT64_C(1) << ((i) + 2))
+
+struct future_wait_bucket {
+	pthread_mutex_t mutex;
+	struct glow_sched_cond cond;
+};
+
+static struct future_wait_bucket wait_table[FUTURE_WAIT_BUCKETS];
+static pthread_once_t wait_table_once = PTHREAD_ONCE_INIT;
+static _Thread_local char wait_key;
+
+static void wait_table_init(void)
+{
+	for (size_t i = 0; i < FUTURE_WAIT_BUCKETS; i++) {
+		GLOW_SAFE(pthread_mutex_init(&wait_table[i].mutex, NULL));
+		glow_sched_cond_init(&wait_table[i].cond);
+	}
+}
+
+/* the bucket the current task, or thread outside of the pool, sleeps in */
+static size_t wait_bucket_index(void)
+{
+	struct glow_task *task = glow_sched_current();
+	const uintptr_t key = (task != NULL) ? (uintptr_t)task : (uintptr_t)&wait_key;
+	return (key >> 6) % FUTURE_WAIT_BUCKETS;
+}
+
 GlowValue glow_future_make(void)
 {
 	GlowFutureObject *future = glow_obj_alloc(&glow_future_class);
 	future->value = glow_makeempty();
-	GLOW_SAFE(pthread_mutex_init(&future->mutex, NULL));
-	GLOW_SAFE(pthread_cond_init(&future->cond, NULL));
+	atomic_init(&future->state, FUTURE_PENDING);
 	return glow_makeobj(future);
 }
 
-GlowValue glow_message_make(GlowValue *contents)
+GlowValue glow_message_make(GlowValue *contents, const bool with_future)
 {
 	GlowMessage *msg = glow_obj_alloc(&glow_message_class);
 	glow_retain(contents);
 	msg->contents = *contents;
-	GlowValue future = glow_future_make();
-	msg->future = glow_objvalue(&future);
+	msg->future = NULL;
+	msg->replied = false;
+
+	if (with_future) {
+		GlowValue future = glow_future_make();
+		msg->future = glow_objvalue(&future);
+	}
+
 	return glow_makeobj(msg);
 }
 
 GlowValue glow_kill_message_make(void)
 {
 	GlowValue empty = glow_makeempty();
-	return glow_message_make(&empty);
+	return glow_message_make(&empty, false);
 }
 
-static void future_set_value(GlowFutureObject *future, GlowValue *v)
+static inline uint64_t future_status(GlowFutureObject *future)
 {
-	glow_release(&future->value);
-	glow_retain(v);
-	future->value = *v;
+	return atomic_load_explicit(&future->state, memory_order_acquire) & FUTURE_STATUS_MASK;
+}
+
+/* only ever called once per future; `v` is NULL if its message was dropped */
+static void future_finish(GlowFutureObject *future, GlowValue *v)
+{
+	uint64_t status = FUTURE_DROPPED;
+
+	if (v != NULL) {
+		glow_share(v);
+		glow_retain(v);
+		future->value = *v;
+		status = FUTURE_DONE;
+	}
+
+	uint64_t waiting = atomic_exchange_explicit(&future->state, status, memory_order_acq_rel) >> 2;
+
+	for (size_t i = 0; waiting != 0; i++, waiting >>= 1) {
+		if (waiting & 1) {
+			struct future_wait_bucket *bucket = &wait_table[i];
+			GLOW_SAFE(pthread_mutex_lock(&bucket->mutex));
+			glow_sched_cond_broadcast(&bucket->cond);
+			GLOW_SAFE(pthread_mutex_unlock(&bucket->mutex));
+		}
+	}
+}
+
+/*
+ * With `any`, sets `pos` to a finished future if there is one.
+ * Otherwise, advances `pos` past the futures that are done, or sets
+ * it to one that was dropped.
+ */
+static bool futures_ready(GlowFutureObject **futures, const size_t n, const bool any, size_t *pos)
+{
+	if (any) {
+		for (size_t i = 0; i < n; i++) {
+			if (future_status(futures[i]) != FUTURE_PENDING) {
+				*pos = i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	while (*pos < n && future_status(futures[*pos]) == FUTURE_DONE) {
+		++*pos;
+	}
+
+	for (size_t i = *pos; i < n; i++) {
+		if (future_status(futures[i]) == FUTURE_DROPPED) {
+			*pos = i;
+			return true;
+		}
+	}
+
+	return *pos == n;
+}
+
+/*
+ * Waits until all of `futures` (or, with `any`, one of them) have
+ * finished; see futures_ready() for `pos`. Returns false if `deadline`
+ * passed first.
+ */
+static bool futures_wait(GlowFutureObject **futures,
+                         const size_t n,
+                         const bool any,
+                         const struct timespec *deadline,
+                         size_t *pos)
+{
+	*pos = 0;
+
+	if (futures_ready(futures, n, any, pos)) {
+		return true;
+	}
+
+	GLOW_SAFE(pthread_once(&wait_table_once, wait_table_init));
+	const size_t index = wait_bucket_index();
+	struct future_wait_bucket *bucket = &wait_table[index];
+	const uint64_t bit = FUTURE_BUCKET_BIT(index);
+	bool ready;
+
+	GLOW_SAFE(pthread_mutex_lock(&bucket->mutex));
+
+	/* finishers wake the bucket once they see our bit; stray bits on finished futures are harmless */
+	for (size_t i = *pos; i < n; i++) {
+		if (!(atomic_load_explicit(&futures[i]->state, memory_order_relaxed) & bit)) {
+			atomic_fetch_or_explicit(&futures[i]->state, bit, memory_order_acq_rel);
+		}
+	}
+
+	while (!(ready = futures_ready(futures, n, any, pos))) {
+		if (deadline == NULL) {
+			glow_sched_cond_wait(&bucket->cond, &bucket->mutex);
+		} else if (!glow_sched_cond_timedwait(&bucket->cond, &bucket->mutex, deadline)) {
+			ready = futures_ready(futures, n, any, pos);
+			break;
+		}
+	}
+
+	GLOW_SAFE(pthread_mutex_unlock(&bucket->mutex));
+	return ready;
+}
+
+/* for a future known to have finished */
+static GlowValue future_result(GlowFutureObject *future)
+{
+	if (future_status(future) == FUTURE_DROPPED) {
+		return GLOW_ACTOR_EXC("message was dropped from a full mailbox");
+	}
+
+	glow_retain(&future->value);
+	return future->value;
+}
+
+/* turns a timeout in milliseconds into an absolute deadline */
+static GlowValue timeout_to_deadline(const char *name, GlowValue *timeout, struct timespec *deadline)
+{
+	if (!glow_isint(timeout)) {
+		GlowClass *class = glow_getclass(timeout);
+		return GLOW_TYPE_EXC("%s() takes an integer timeout (got a %s)", name, class->name);
+	}
+
+	const long ms = glow_intvalue(timeout);
+
+	if (ms < 0) {
+		return GLOW_TYPE_EXC("%s() got a negative timeout", name);
+	}
+
+	timespec_get(deadline, TIME_UTC);
+	deadline->tv_sec += ms/1000;
+	deadline->tv_nsec += (ms % 1000) * 1000000;
+
+	if (deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec += 1;
+		deadline->tv_nsec -= 1000000000;
+	}
+
+	return glow_makenull();
 }
 
 static void future_free(GlowValue *this)
 {
 	GlowFutureObject *future = glow_objvalue(this);
 	glow_release(&future->value);
-	GLOW_SAFE(pthread_mutex_destroy(&future->mutex));
-	GLOW_SAFE(pthread_cond_destroy(&future->cond));
 	glow_obj_class.del(this);
 }
 
@@ -517,65 +1303,117 @@ static GlowValue future_get(GlowValue *this,
 	GLOW_ARG_COUNT_CHECK_AT_MOST(NAME, nargs, 1);
 
 	GlowFutureObject *future = glow_objvalue(this);
-	bool timeout = false;
+	struct timespec deadline;
+	size_t pos;
+	glow_refcnt_merge_pending();
 
 	if (nargs > 0) {
-		if (!glow_isint(&args[0])) {
-			GlowClass *class = glow_getclass(&args[0]);
-			return GLOW_TYPE_EXC(NAME "() takes an integer argument (got a %s)", class->name);
+		GlowValue status = timeout_to_deadline(NAME, &args[0], &deadline);
+
+		if (glow_iserror(&status)) {
+			return status;
 		}
+	}
 
-		const long ms = glow_intvalue(&args[0]);
+	if (!futures_wait(&future, 1, false, (nargs > 0) ? &deadline : NULL, &pos)) {
+		return GLOW_ACTOR_EXC(NAME "() timed out");
+	}
 
-		if (ms < 0) {
-			GlowClass *class = glow_getclass(&args[0]);
-			return GLOW_TYPE_EXC(NAME "() got a negative argument", class->name);
-		}
+	return future_result(future);
 
-		struct timespec ts;
-		struct timeval tv;
+#undef NAME
+}
 
-		GLOW_SAFE(gettimeofday(&tv, NULL));
+/* `all` or `any`, with a list of futures and an optional timeout */
+static GlowValue futures_gather(const char *name, GlowValue *args, size_t nargs, const bool any)
+{
+	if (!glow_is_a(&args[0], &glow_list_class)) {
+		GlowClass *class = glow_getclass(&args[0]);
+		return GLOW_TYPE_EXC("%s() takes a list of futures (got a %s)", name, class->name);
+	}
 
-#ifndef TIMEVAL_TO_TIMESPEC
-#define	TIMEVAL_TO_TIMESPEC(tv, ts)            \
-	do {                                       \
-		(ts)->tv_sec = (tv)->tv_sec;           \
-		(ts)->tv_nsec = (tv)->tv_usec * 1000;  \
-	} while (0)
-#endif
+	struct timespec deadline;
 
-		TIMEVAL_TO_TIMESPEC(&tv, &ts);
-		ts.tv_sec += ms/1000;
-		ts.tv_nsec += (ms % 1000) * 1000000;
+	if (nargs > 1) {
+		GlowValue status = timeout_to_deadline(name, &args[1], &deadline);
 
-		GLOW_SAFE(pthread_mutex_lock(&future->mutex));
-		while (glow_isempty(&future->value)) {
-			int n = pthread_cond_timedwait(&future->cond, &future->mutex, &ts);
+		if (glow_iserror(&status)) {
+			return status;
+		}
+	}
 
-			if (n == ETIMEDOUT) {
-				timeout = true;
-				break;
-			} else if (n) {
-				GLOW_INTERNAL_ERROR();
+	GlowListObject *list = glow_objvalue(&args[0]);
+	GLOW_ENTER(list);
+	const size_t n = list->count;
+
+	if (any && n == 0) {
+		GLOW_EXIT(list);
+		return GLOW_TYPE_EXC("%s() takes a non-empty list", name);
+	}
+
+	/* holds on to the futures in case the list changes while we wait */
+	GlowFutureObject **futures = glow_malloc(n * sizeof(GlowFutureObject *));
+
+	for (size_t i = 0; i < n; i++) {
+		GlowValue *v = &list->elements[i];
+
+		if (!glow_is_a(v, &glow_future_class)) {
+			GLOW_EXIT(list);
+			for (size_t j = 0; j < i; j++) {
+				glow_releaseo(futures[j]);
 			}
+			free(futures);
+			GlowClass *class = glow_getclass(v);
+			return GLOW_TYPE_EXC("%s() takes a list of futures (found a %s)", name, class->name);
 		}
-		GLOW_SAFE(pthread_mutex_unlock(&future->mutex));
+
+		futures[i] = glow_objvalue(v);
+		glow_retaino(futures[i]);
+	}
+	GLOW_EXIT(list);
+
+	glow_refcnt_merge_pending();
+	size_t pos;
+	GlowValue res;
+
+	if (!futures_wait(futures, n, any, (nargs > 1) ? &deadline : NULL, &pos)) {
+		res = GLOW_ACTOR_EXC("%s() timed out", name);
+	} else if (any) {
+		res = glow_makeint(pos);
+	} else if (pos < n) {
+		res = future_result(futures[pos]);  /* dropped */
 	} else {
-		GLOW_SAFE(pthread_mutex_lock(&future->mutex));
-		while (glow_isempty(&future->value)) {
-			GLOW_SAFE(pthread_cond_wait(&future->cond, &future->mutex));
+		GlowValue *values = glow_malloc(n * sizeof(GlowValue));
+
+		for (size_t i = 0; i < n; i++) {
+			values[i] = future_result(futures[i]);
 		}
-		GLOW_SAFE(pthread_mutex_unlock(&future->mutex));
+
+		res = glow_list_make(values, n);
+		free(values);
 	}
 
-	if (timeout) {
-		return GLOW_ACTOR_EXC(NAME "() timed out");
-	} else {
-		glow_retain(&future->value);
-		return future->value;
+	for (size_t i = 0; i < n; i++) {
+		glow_releaseo(futures[i]);
 	}
 
+	free(futures);
+	return res;
+}
+
+static GlowValue future_all(GlowValue *args, size_t nargs)
+{
+#define NAME "all"
+	GLOW_ARG_COUNT_CHECK_BETWEEN(NAME, nargs, 1, 2);
+	return futures_gather(NAME, args, nargs, false);
+#undef NAME
+}
+
+static GlowValue future_any(GlowValue *args, size_t nargs)
+{
+#define NAME "any"
+	GLOW_ARG_COUNT_CHECK_BETWEEN(NAME, nargs, 1, 2);
+	return futures_gather(NAME, args, nargs, true);
 #undef NAME
 }
 
@@ -613,20 +1451,22 @@ static GlowValue message_reply(GlowValue *this,
 
 	GlowMessage *msg = glow_objvalue(this);
 	GlowFutureObject *future = msg->future;
-	GlowValue ret;
 
-	GLOW_SAFE(pthread_mutex_lock(&future->mutex));
-	if (future != NULL) {
-		future_set_value(future, &args[0]);
-		GLOW_SAFE(pthread_cond_broadcast(&future->cond));
-		glow_releaseo(future);
-		msg->future = NULL;
-		ret = glow_makenull();
-	} else {
-		ret = GLOW_ACTOR_EXC("cannot reply to the same message twice");
+	if (msg->replied) {
+		return GLOW_ACTOR_EXC("cannot reply to the same message twice");
 	}
-	GLOW_SAFE(pthread_mutex_unlock(&future->mutex));
-	return ret;
+
+	msg->replied = true;
+
+	/* nobody is waiting on a told message */
+	if (future == NULL) {
+		return glow_makenull();
+	}
+
+	future_finish(future, &args[0]);
+	msg->future = NULL;
+	glow_releaseo(future);
+	return glow_makenull();
 
 #undef NAME
 }
@@ -636,6 +1476,15 @@ struct glow_attr_method future_methods[] = {
 	{NULL, NULL}
 };
 
+static GlowNativeFuncObject future_all_nfo = GLOW_NFUNC_INIT(future_all);
+static GlowNativeFuncObject future_any_nfo = GLOW_NFUNC_INIT(future_any);
+
+struct glow_attr_static future_statics[] = {
+	{"all", &future_all_nfo},
+	{"any", &future_any_nfo},
+	{NULL, NULL}
+};
+
 struct glow_attr_method message_methods[] = {
 	{"contents", message_contents},
 	{"reply", message_reply},
@@ -655,6 +1504,9 @@ GlowClass glow_actor_proxy_class = {
 	.init = NULL,
 	.del = actor_proxy_free,
 
+	.traverse = actor_proxy_traverse,
+	.clear = actor_proxy_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
@@ -686,6 +1538,9 @@ GlowClass glow_actor_class = {
 	.init = NULL,
 	.del = actor_free,
 
+	.traverse = actor_traverse,
+	.clear = actor_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
@@ -733,6 +1588,7 @@ GlowClass glow_future_class = {
 
 	.members = NULL,
 	.methods = future_methods,
+	.statics = future_statics,
 
 	.attr_get = NULL,
 	.attr_set = NULL
@@ -19,7 +19,7 @@ static GlowValue bool_eq(GlowValue *this, GlowValue *other)
 
 static GlowValue bool_hash(GlowValue *this)
 {
-	return glow_makeint(glow_util_hash_bool(glow_boolvalue(this)));
+	return glow_makehash(glow_util_hash_bool(glow_boolvalue(this)));
 }
 
 static GlowValue bool_cmp(GlowValue *this, GlowValue *other)
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include "code.h"
 #include "compiler.h"
@@ -36,11 +37,17 @@
  *   - Name (null-terminated string)
  *   - Argument count (uint16)
  *   - Value stack size (uint16)
+ *
+ * The line number table is directly followed by the exception
+ * handler table: an entry count (uint16) and then the entries
+ * themselves, as described in compiler.h.
  */
 
 static void read_lno_table(GlowCodeObject *co, GlowCode *code);
+static void read_exc_table(GlowCodeObject *co, GlowCode *code);
 static void read_sym_table(GlowCodeObject *co, GlowCode *code);
 static void read_const_table(GlowCodeObject *co, GlowCode *code);
+static void init_attr_caches(GlowCodeObject *co, const size_t size);
 
 /*
  * stack_depth = -1 means that the depth must be read
@@ -50,22 +57,24 @@ GlowCodeObject *glow_codeobj_make(GlowCode *code,
                                 const char *name,
                                 unsigned int argcount,
                                 int stack_depth,
-                                int try_catch_depth,
                                 GlowVM *vm)
 {
 	GlowCodeObject *co = glow_obj_alloc(&glow_co_class);
 	co->name = name;
 	co->vm = vm;
 	read_lno_table(co, code);
+	read_exc_table(co, code);
 	read_sym_table(co, code);
 	read_const_table(co, code);
 	co->hints = NULL;
 	co->bc = code->bc;
 	co->argcount = argcount;
 	co->stack_depth = stack_depth;
-	co->try_catch_depth = try_catch_depth;
-	co->frame = NULL;
+	co->frame_pool = NULL;
+	co->frame_pool_size = 0;
+	atomic_flag_clear(&co->frame_pool_lock);
 	co->cache = glow_calloc(code->size, sizeof(struct glow_code_cache));
+	init_attr_caches(co, code->size);
 	return co;
 }
 
@@ -74,18 +83,17 @@ GlowCodeObject *glow_codeobj_make_toplevel(GlowCode *code,
                                          GlowVM *vm)
 {
 	unsigned int stack_depth = glow_code_read_uint16(code);
-	unsigned int try_catch_depth = glow_code_read_uint16(code);
-	return glow_codeobj_make(code, name, 0, stack_depth, try_catch_depth, vm);
+	return glow_codeobj_make(code, name, 0, stack_depth, vm);
 }
 
-/* last element of `types` should be return value hint */
+/* last element of `types` should be return value hint; NULL `types` means no hints */
 GlowValue glow_codeobj_init_hints(GlowCodeObject *co, GlowValue *types)
 {
 	const size_t n_hints = co->argcount + 1;
 	co->hints = glow_malloc(n_hints * sizeof(GlowClass *));
 
 	for (size_t i = 0; i < n_hints; i++) {
-		if (glow_isnull(&types[i])) {
+		if (types == NULL || glow_isnull(&types[i])) {
 			co->hints[i] = NULL;
 			continue;
 		}
@@ -114,6 +122,9 @@ static void codeobj_free(GlowValue *this)
 	free(co->names.array);
 	free(co->attrs.array);
 	free(co->frees.array);
+	free(co->attr_keys);
+	free(co->free_keys);
+	free(co->free_values);
 
 	struct glow_value_array *consts = &co->consts;
 	GlowValue *consts_array = consts->array;
@@ -136,13 +147,45 @@ static void codeobj_free(GlowValue *this)
 
 	free(hints_array);
 
-	glow_frame_free(co->frame);
+	glow_frame_pool_free(co);
 
+	free(co->exc_handlers);
 	free(co->cache);
+	free(co->attr_caches);
 
 	glow_obj_class.del(this);
 }
 
+/*
+ * Assigns an attribute cache to each LOAD_ATTR/SET_ATTR/LOAD_METHOD instruction
+ * in the `size`-byte code segment.
+ */
+static void init_attr_caches(GlowCodeObject *co, const size_t size)
+{
+	const byte *bc = co->bc;
+	size_t n_caches = 0;
+
+	size_t pos = 0;
+	while (pos < size) {
+		const byte opcode = bc[pos];
+		const int arg_size = glow_opcode_arg_size(opcode);
+
+		if (arg_size < 0) {
+			GLOW_INTERNAL_ERROR();
+		}
+
+		if ((opcode == GLOW_INS_LOAD_ATTR ||
+		     opcode == GLOW_INS_SET_ATTR ||
+		     opcode == GLOW_INS_LOAD_METHOD) && n_caches < USHRT_MAX) {
+			co->cache[pos].attr_cache = ++n_caches;
+		}
+
+		pos += 1 + arg_size;
+	}
+
+	co->attr_caches = (n_caches > 0) ? glow_calloc(n_caches, sizeof(struct glow_attr_cache)) : NULL;
+}
+
 static void read_lno_table(GlowCodeObject *co, GlowCode *code)
 {
 	const unsigned int first_lineno = glow_code_read_uint16(code);
@@ -156,6 +199,22 @@ static void read_lno_table(GlowCodeObject *co, GlowCode *code)
 	}
 }
 
+static void read_exc_table(GlowCodeObject *co, GlowCode *code)
+{
+	const unsigned int n_handlers = glow_code_read_uint16(code);
+	struct glow_exc_handler *handlers = glow_malloc(n_handlers * sizeof(struct glow_exc_handler));
+
+	for (unsigned int i = 0; i < n_handlers; i++) {
+		handlers[i].start = glow_code_read_uint16(code);
+		handlers[i].end = glow_code_read_uint16(code);
+		handlers[i].handler = glow_code_read_uint16(code);
+		handlers[i].depth = glow_code_read_uint16(code);
+	}
+
+	co->exc_handlers = handlers;
+	co->n_exc_handlers = n_handlers;
+}
+
 /*
  * Symbol table has 3 components:
  *
@@ -170,6 +229,18 @@ static void read_lno_table(GlowCodeObject *co, GlowCode *code)
  *
  * Example table: 2 0 'f' 'o' 'o' 0 'b' 'a' 'r' 0
  */
+/* `strs` must be interned */
+static GlowStr *make_keys(struct glow_str_array *strs)
+{
+	GlowStr *keys = glow_malloc(strs->length * sizeof(GlowStr));
+
+	for (size_t i = 0; i < strs->length; i++) {
+		keys[i] = *glow_str_intern(strs->array[i].str, strs->array[i].length);
+	}
+
+	return keys;
+}
+
 static void read_sym_table(GlowCodeObject *co, GlowCode *code)
 {
 	assert(glow_code_read_byte(code) == GLOW_ST_ENTRY_BEGIN);
@@ -196,7 +267,7 @@ static void read_sym_table(GlowCodeObject *co, GlowCode *code)
 
 		assert(len > 0);
 
-		names.array[i].str = (char *)symtab_bc + off;
+		names.array[i].str = glow_str_intern((char *)symtab_bc + off, len)->value;
 		names.array[i].length = len;
 		off += len + 1;
 	}
@@ -217,7 +288,7 @@ static void read_sym_table(GlowCodeObject *co, GlowCode *code)
 
 		assert(len > 0);
 
-		attrs.array[i].str = (char *)symtab_bc + off;
+		attrs.array[i].str = glow_str_intern((char *)symtab_bc + off, len)->value;
 		attrs.array[i].length = len;
 		off += len + 1;
 	}
@@ -238,7 +309,7 @@ static void read_sym_table(GlowCodeObject *co, GlowCode *code)
 
 		assert(len > 0);
 
-		frees.array[i].str = (char *)symtab_bc + off;
+		frees.array[i].str = glow_str_intern((char *)symtab_bc + off, len)->value;
 		frees.array[i].length = len;
 		off += len + 1;
 	}
@@ -246,6 +317,13 @@ static void read_sym_table(GlowCodeObject *co, GlowCode *code)
 	co->names = names;
 	co->attrs = attrs;
 	co->frees = frees;
+	co->attr_keys = make_keys(&attrs);
+	co->free_keys = make_keys(&frees);
+
+	co->free_values = glow_malloc(n_frees * sizeof(GlowValue));
+	for (size_t i = 0; i < n_frees; i++) {
+		co->free_values[i] = glow_vm_get_builtin(&co->free_keys[i]);
+	}
 }
 
 static void read_const_table(GlowCodeObject *co, GlowCode *code)
@@ -264,16 +342,12 @@ static void read_const_table(GlowCodeObject *co, GlowCode *code)
 			GLOW_INTERNAL_ERROR();
 			break;
 		case GLOW_CT_ENTRY_INT:
-			constants[i].type = GLOW_VAL_TYPE_INT;
-			constants[i].data.i = glow_code_read_int(code);
+			constants[i] = glow_makeint(glow_code_read_int(code));
 			break;
 		case GLOW_CT_ENTRY_FLOAT:
-			constants[i].type = GLOW_VAL_TYPE_FLOAT;
-			constants[i].data.f = glow_code_read_double(code);
+			constants[i] = glow_makefloat(glow_code_read_double(code));
 			break;
 		case GLOW_CT_ENTRY_STRING: {
-			constants[i].type = GLOW_VAL_TYPE_OBJECT;
-
 			/*
 			 * We read this string manually so we have
 			 * access to its length:
@@ -284,22 +358,16 @@ static void read_const_table(GlowCodeObject *co, GlowCode *code)
 				++str_len;
 			}
 
-			char *str = glow_malloc(str_len + 1);
-			for (size_t j = 0; j < str_len; j++) {
-				str[j] = glow_code_read_byte(code);
-			}
-			str[str_len] = '\0';
-			glow_code_read_byte(code);  /* skip the string termination byte */
-			constants[i] = glow_strobj_make(GLOW_STR_INIT(str, str_len, 1));
+			const GlowStr *str = glow_str_intern((char *)code->bc, str_len);
+			glow_code_skip_ahead(code, str_len + 1);  /* include the string termination byte */
+			constants[i] = glow_strobj_make(*str);
 			break;
 		}
 		case GLOW_CT_ENTRY_CODEOBJ: {
-			constants[i].type = GLOW_VAL_TYPE_OBJECT;
 			const size_t code_len = glow_code_read_uint16(code);
 			const char *name = glow_code_read_str(code);
 			const unsigned int argcount = glow_code_read_uint16(code);
 			const unsigned int stack_depth = glow_code_read_uint16(code);
-			const unsigned int try_catch_depth = glow_code_read_uint16(code);
 
 			GlowCode sub;
 			sub.bc = code->bc;
@@ -307,12 +375,11 @@ static void read_const_table(GlowCodeObject *co, GlowCode *code)
 			sub.capacity = 0;
 			glow_code_skip_ahead(code, code_len);
 
-			constants[i].data.o = glow_codeobj_make(&sub,
-			                                       name,
-			                                       argcount,
-			                                       stack_depth,
-			                                       try_catch_depth,
-			                                       co->vm);
+			constants[i] = glow_makeobj(glow_codeobj_make(&sub,
+			                                            name,
+			                                            argcount,
+			                                            stack_depth,
+			                                            co->vm));
 			break;
 		}
 		case GLOW_CT_ENTRY_END:
@@ -338,9 +405,10 @@ GlowValue glow_codeobj_load_args(GlowCodeObject *co,
 {
 #define RELEASE_ALL() \
 	do { \
-		for (unsigned i = 0; i < argcount; i++) \
-			if (locals[i].type != GLOW_VAL_TYPE_EMPTY) \
-				glow_release(&locals[i]); \
+		for (unsigned i = 0; i < argcount; i++) { \
+			glow_release(&locals[i]); \
+			locals[i] = glow_makeempty(); \
+		} \
 	} while (0)
 
 	const unsigned int argcount = co->argcount;
@@ -366,7 +434,7 @@ GlowValue glow_codeobj_load_args(GlowCodeObject *co,
 		bool found = false;
 		for (unsigned j = 0; j < argcount; j++) {
 			if (strcmp(name->str.value, names.array[j].str) == 0) {
-				if (locals[j].type != GLOW_VAL_TYPE_EMPTY) {
+				if (!glow_isempty(&locals[j])) {
 					RELEASE_ALL();
 					return glow_call_exc_dup_arg(co->name, name->str.value);
 				}
@@ -394,20 +462,21 @@ GlowValue glow_codeobj_load_args(GlowCodeObject *co,
 
 	if (defaults == NULL) {
 		for (unsigned i = 0; i < argcount; i++) {
-			if (locals[i].type == GLOW_VAL_TYPE_EMPTY) {
+			if (glow_isempty(&locals[i])) {
 				RELEASE_ALL();
 				return glow_call_exc_missing_arg(co->name, names.array[i].str);
 			}
 
 			if (hints[i] != NULL && !glow_is_a(&locals[i], hints[i])) {
+				GlowValue exc = glow_type_exc_hint_mismatch(glow_getclass(&locals[i]), hints[i]);
 				RELEASE_ALL();
-				return glow_type_exc_hint_mismatch(glow_getclass(&locals[i]), hints[i]);
+				return exc;
 			}
 		}
 	} else {
 		const unsigned int limit = argcount - n_defaults;  /* where the defaults start */
 		for (unsigned i = 0; i < argcount; i++) {
-			if (locals[i].type == GLOW_VAL_TYPE_EMPTY) {
+			if (glow_isempty(&locals[i])) {
 				if (i >= limit) {
 					locals[i] = defaults[i - limit];
 					glow_retain(&locals[i]);
@@ -418,8 +487,9 @@ GlowValue glow_codeobj_load_args(GlowCodeObject *co,
 			}
 
 			if (hints[i] != NULL && !glow_is_a(&locals[i], hints[i])) {
+				GlowValue exc = glow_type_exc_hint_mismatch(glow_getclass(&locals[i]), hints[i]);
 				RELEASE_ALL();
-				return glow_type_exc_hint_mismatch(glow_getclass(&locals[i]), hints[i]);
+				return exc;
 			}
 		}
 	}
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include "exc.h"
 #include "strbuf.h"
@@ -10,30 +11,200 @@
 #include "tupleobject.h"
 #include "iter.h"
 #include "util.h"
+#include "gc.h"
 #include "dictobject.h"
 
-#define EMPTY_SIZE  16
-#define LOAD_FACTOR 0.75f
+/*
+ * Compact dict: items live densely in `entries`, in insertion order,
+ * while `indices` is an open-addressing table mapping hashes to entry
+ * positions. Deleted items leave a hole in `entries` (an empty key) and
+ * a dummy in `indices` until the next resize compacts the table. Index
+ * slots are only as wide as the table size requires.
+ */
+
+#define EMPTY_SIZE    8
+#define USABLE(cap)   (((cap) << 1) / 3)
+#define PERTURB_SHIFT 5
+
+#define IX_EMPTY (-1)
+#define IX_DUMMY (-2)
+
+#define IX8_MAX_CAPACITY  ((size_t)1 << 7)
+#define IX16_MAX_CAPACITY ((size_t)1 << 15)
+#define IX32_MAX_CAPACITY ((size_t)1 << 31)
 
 typedef struct glow_dict_entry Entry;
 
 #define KEY_EXC(key) GLOW_INDEX_EXC("dict has no key '%s'", (key));
 
-static Entry **make_empty_table(const size_t capacity);
 static void dict_resize(GlowDictObject *dict, const size_t new_capacity);
 static void dict_free(GlowValue *this);
 
-GlowValue glow_dict_make(GlowValue *entries, const size_t size)
+static inline size_t index_width(const size_t capacity)
 {
-	GlowDictObject *dict = glow_obj_alloc(&glow_dict_class);
-	GLOW_INIT_SAVED_TID_FIELD(dict);
+	if (capacity <= IX8_MAX_CAPACITY) {
+		return sizeof(int8_t);
+	} else if (capacity <= IX16_MAX_CAPACITY) {
+		return sizeof(int16_t);
+	} else if (capacity <= IX32_MAX_CAPACITY) {
+		return sizeof(int32_t);
+	} else {
+		return sizeof(int64_t);
+	}
+}
+
+static inline long ix_get(GlowDictObject *dict, const size_t i)
+{
+	const size_t capacity = dict->capacity;
 
-	const size_t capacity = (size == 0) ? EMPTY_SIZE : glow_smallest_pow_2_at_least(size);
+	if (capacity <= IX8_MAX_CAPACITY) {
+		return ((int8_t *)dict->indices)[i];
+	} else if (capacity <= IX16_MAX_CAPACITY) {
+		return ((int16_t *)dict->indices)[i];
+	} else if (capacity <= IX32_MAX_CAPACITY) {
+		return ((int32_t *)dict->indices)[i];
+	} else {
+		return ((int64_t *)dict->indices)[i];
+	}
+}
+
+static inline void ix_set(GlowDictObject *dict, const size_t i, const long ix)
+{
+	const size_t capacity = dict->capacity;
 
-	dict->entries = make_empty_table(capacity);
+	if (capacity <= IX8_MAX_CAPACITY) {
+		((int8_t *)dict->indices)[i] = (int8_t)ix;
+	} else if (capacity <= IX16_MAX_CAPACITY) {
+		((int16_t *)dict->indices)[i] = (int16_t)ix;
+	} else if (capacity <= IX32_MAX_CAPACITY) {
+		((int32_t *)dict->indices)[i] = (int32_t)ix;
+	} else {
+		((int64_t *)dict->indices)[i] = (int64_t)ix;
+	}
+}
+
+/* smallest capacity with room for `n` items */
+static size_t capacity_for(const size_t n)
+{
+	size_t capacity = EMPTY_SIZE;
+	while (USABLE(capacity) < n) {
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+/* sets up an empty table; indices and entries share one allocation */
+static void table_init(GlowDictObject *dict, const size_t capacity)
+{
+	const size_t indices_size = capacity * index_width(capacity);  /* multiple of 8 */
+	char *table = glow_malloc(indices_size + USABLE(capacity) * sizeof(Entry));
+	memset(table, 0xff, indices_size);  /* IX_EMPTY */
+
+	dict->indices = table;
+	dict->entries = (Entry *)(table + indices_size);
 	dict->count = 0;
+	dict->n_entries = 0;
 	dict->capacity = capacity;
-	dict->threshold = (size_t)(capacity * LOAD_FACTOR);
+}
+
+static inline bool same_key(GlowValue *a, GlowValue *b)
+{
+	if (glow_isobject(a)) {
+		return glow_isobject(b) && glow_objvalue(a) == glow_objvalue(b);
+	}
+
+	return glow_isint(a) && glow_isint(b) && glow_intvalue(a) == glow_intvalue(b);
+}
+
+/*
+ * Returns the position in `entries` of the item with the given key, or
+ * -1 if there is none. The index slot of the item is stored in `slot`
+ * if non-NULL. An error raised by `eq` is stored in `error`, with -1
+ * being returned.
+ */
+static long lookup(GlowDictObject *dict, GlowValue *key, const int hash, size_t *slot, GlowValue *error)
+{
+	GlowBinOp eq = NULL;
+	const size_t mask = dict->capacity - 1;
+	size_t perturb = (unsigned int)hash;
+	size_t i = perturb & mask;
+
+	while (true) {
+		const long ix = ix_get(dict, i);
+
+		if (ix == IX_EMPTY) {
+			return -1;
+		}
+
+		if (ix >= 0 && dict->entries[ix].hash == hash) {
+			GlowValue *entry_key = &dict->entries[ix].key;
+
+			if (same_key(key, entry_key)) {
+				goto found;
+			}
+
+			/* every value should have a valid `eq` */
+			if (eq == NULL) {
+				eq = glow_resolve_eq(glow_getclass(key));
+			}
+
+			GlowValue eq_v = eq(key, entry_key);
+
+			if (glow_iserror(&eq_v)) {
+				*error = eq_v;
+				return -1;
+			}
+
+			if (glow_boolvalue(&eq_v)) {
+				goto found;
+			}
+		}
+
+		perturb >>= PERTURB_SHIFT;
+		i = (i*5 + perturb + 1) & mask;
+		continue;
+
+		found:
+		if (slot != NULL) {
+			*slot = i;
+		}
+		return ix;
+	}
+}
+
+static size_t find_empty_slot(GlowDictObject *dict, const int hash)
+{
+	const size_t mask = dict->capacity - 1;
+	size_t perturb = (unsigned int)hash;
+	size_t i = perturb & mask;
+
+	while (ix_get(dict, i) != IX_EMPTY) {
+		perturb >>= PERTURB_SHIFT;
+		i = (i*5 + perturb + 1) & mask;
+	}
+
+	return i;
+}
+
+/* appends a new item (references to which are stolen); there must be room */
+static void insert_new(GlowDictObject *dict, GlowValue *key, GlowValue *value, const int hash)
+{
+	const size_t n = dict->n_entries;
+	Entry *entry = &dict->entries[n];
+	entry->key = *key;
+	entry->value = *value;
+	entry->hash = hash;
+	ix_set(dict, find_empty_slot(dict, hash), (long)n);
+	dict->n_entries = n + 1;
+	++dict->count;
+}
+
+GlowValue glow_dict_make(GlowValue *entries, const size_t size)
+{
+	GlowDictObject *dict = glow_obj_alloc(&glow_dict_class);
+	GLOW_INIT_SAVED_TID_FIELD(dict);
+
+	table_init(dict, capacity_for(size / 2));
 	dict->state_id = 0;
 
 	for (size_t i = 0; i < size; i += 2) {
@@ -58,19 +229,10 @@ GlowValue glow_dict_make(GlowValue *entries, const size_t size)
 		glow_release(value);
 	}
 
+	glow_gc_track(dict);
 	return glow_makeobj(dict);
 }
 
-static Entry *make_entry(GlowValue *key, GlowValue *value, const int hash)
-{
-	Entry *entry = glow_malloc(sizeof(Entry));
-	entry->key = *key;
-	entry->value = *value;
-	entry->hash = hash;
-	entry->next = NULL;
-	return entry;
-}
-
 GlowValue glow_dict_get(GlowDictObject *dict, GlowValue *key, GlowValue *dflt)
 {
 	const GlowValue hash_v = glow_op_hash(key);
@@ -80,26 +242,17 @@ GlowValue glow_dict_get(GlowDictObject *dict, GlowValue *key, GlowValue *dflt)
 	}
 
 	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
+	GlowValue error = glow_makeempty();
+	const long ix = lookup(dict, key, hash, NULL, &error);
 
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(key));
-
-	for (Entry *entry = dict->entries[hash & (dict->capacity - 1)];
-	     entry != NULL;
-	     entry = entry->next) {
-
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(key, &entry->key);
-
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	if (ix >= 0) {
+		GlowValue *value = &dict->entries[ix].value;
+		glow_retain(value);
+		return *value;
+	}
 
-			if (glow_boolvalue(&eq_v)) {
-				glow_retain(&entry->value);
-				return entry->value;
-			}
-		}
+	if (glow_iserror(&error)) {
+		return error;
 	}
 
 	if (dflt != NULL) {
@@ -121,8 +274,6 @@ GlowValue glow_dict_get(GlowDictObject *dict, GlowValue *key, GlowValue *dflt)
 
 GlowValue glow_dict_put(GlowDictObject *dict, GlowValue *key, GlowValue *value)
 {
-	Entry **table = dict->entries;
-	const size_t capacity = dict->capacity;
 	const GlowValue hash_v = glow_op_hash(key);
 
 	if (glow_iserror(&hash_v)) {
@@ -131,44 +282,28 @@ GlowValue glow_dict_put(GlowDictObject *dict, GlowValue *key, GlowValue *value)
 
 	++dict->state_id;
 	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
-	const size_t index = hash & (capacity - 1);
-
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(key));
-
-	for (Entry *entry = table[index];
-	     entry != NULL;
-	     entry = entry->next) {
-
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(key, &entry->key);
+	GlowValue error = glow_makeempty();
+	const long ix = lookup(dict, key, hash, NULL, &error);
+
+	if (ix >= 0) {
+		Entry *entry = &dict->entries[ix];
+		glow_retain(value);
+		GlowValue old = entry->value;
+		entry->value = *value;
+		return old;
+	}
 
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	if (glow_iserror(&error)) {
+		return error;
+	}
 
-			if (glow_boolvalue(&eq_v)) {
-				glow_retain(value);
-				GlowValue old = entry->value;
-				entry->value = *value;
-				return old;
-			}
-		}
+	if (dict->n_entries == USABLE(dict->capacity)) {
+		dict_resize(dict, capacity_for(3 * dict->count / 2 + 1));
 	}
 
 	glow_retain(key);
 	glow_retain(value);
-
-	Entry *entry = make_entry(key, value, hash);
-	entry->next = table[index];
-	table[index] = entry;
-
-	if (dict->count++ >= dict->threshold) {
-		const size_t new_capacity = (2 * capacity);
-		dict_resize(dict, new_capacity);
-		dict->threshold = (size_t)(new_capacity * LOAD_FACTOR);
-	}
-
+	insert_new(dict, key, value, hash);
 	return glow_makeempty();
 }
 
@@ -181,53 +316,30 @@ GlowValue glow_dict_remove_key(GlowDictObject *dict, GlowValue *key)
 	}
 
 	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
+	GlowValue error = glow_makeempty();
+	size_t slot;
+	const long ix = lookup(dict, key, hash, &slot, &error);
 
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(key));
-
-	Entry **entries = dict->entries;
-	const size_t idx = hash & (dict->capacity - 1);
-	Entry *entry = entries[idx];
-	Entry *prev = entry;
-
-	while (entry != NULL) {
-		Entry *next = entry->next;
-
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(key, &entry->key);
-
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	if (ix < 0) {
+		return error;  /* empty if there simply is no such key */
+	}
 
-			if (glow_boolvalue(&eq_v)) {
-				GlowValue value = entry->value;
-
-				if (prev == entry) {
-					entries[idx] = next;
-				} else {
-					prev->next = next;
-				}
-
-				glow_release(&entry->key);
-				free(entry);
-				--dict->count;
-				++dict->state_id;
-				return value;
-			}
-		}
+	Entry *entry = &dict->entries[ix];
+	GlowValue value = entry->value;
+	GlowValue old_key = entry->key;
 
-		prev = entry;
-		entry = next;
-	}
+	ix_set(dict, slot, IX_DUMMY);
+	entry->key = glow_makeempty();
+	entry->value = glow_makeempty();
+	--dict->count;
+	++dict->state_id;
 
-	return glow_makeempty();
+	glow_release(&old_key);
+	return value;
 }
 
 GlowValue glow_dict_contains_key(GlowDictObject *dict, GlowValue *key)
 {
-	Entry **entries = dict->entries;
-	const size_t capacity = dict->capacity;
 	GlowValue hash_v = glow_op_hash(key);
 
 	if (glow_iserror(&hash_v)) {
@@ -236,29 +348,14 @@ GlowValue glow_dict_contains_key(GlowDictObject *dict, GlowValue *key)
 	}
 
 	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
-	const size_t idx = hash & (capacity - 1);
-
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(key));
-
-	for (Entry *entry = entries[idx];
-	     entry != NULL;
-	     entry = entry->next) {
-
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(key, &entry->key);
-
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	GlowValue error = glow_makeempty();
+	const long ix = lookup(dict, key, hash, NULL, &error);
 
-			if (glow_boolvalue(&eq_v)) {
-				return glow_maketrue();
-			}
-		}
+	if (glow_iserror(&error)) {
+		return error;
 	}
 
-	return glow_makefalse();
+	return glow_makebool(ix >= 0);
 }
 
 GlowValue glow_dict_eq(GlowDictObject *dict, GlowDictObject *other)
@@ -267,42 +364,34 @@ GlowValue glow_dict_eq(GlowDictObject *dict, GlowDictObject *other)
 		return glow_makefalse();
 	}
 
-	GlowDictObject *d1, *d2;
-
-	if (dict->capacity < other->capacity) {
-		d1 = dict;
-		d2 = other;
-	} else {
-		d1 = other;
-		d2 = dict;
-	}
-
-	Entry **entries = d1->entries;
-	size_t capacity = d1->capacity;
 	static GlowValue empty = GLOW_MAKE_EMPTY();
+	Entry *entries = dict->entries;
+	const size_t n_entries = dict->n_entries;
 
-	for (size_t i = 0; i < capacity; i++) {
-		for (Entry *entry = entries[i];
-		     entry != NULL;
-		     entry = entry->next) {
+	for (size_t i = 0; i < n_entries; i++) {
+		Entry *entry = &entries[i];
 
-			GlowValue v1 = entry->value;
-			const GlowBinOp eq = glow_resolve_eq(glow_getclass(&v1));
-			GlowValue v2 = glow_dict_get(d2, &entry->key, &empty);
+		if (glow_isempty(&entry->key)) {
+			continue;
+		}
 
-			if (glow_isempty(&v2)) {
-				goto neq;
-			}
+		GlowValue v1 = entry->value;
+		const GlowBinOp eq = glow_resolve_eq(glow_getclass(&v1));
+		GlowValue v2 = glow_dict_get(other, &entry->key, &empty);
 
-			GlowValue eq_v = eq(&v1, &v2);
+		if (glow_isempty(&v2)) {
+			goto neq;
+		}
 
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+		GlowValue eq_v = eq(&v1, &v2);
+		glow_release(&v2);
 
-			if (!glow_boolvalue(&eq_v)) {
-				goto neq;
-			}
+		if (glow_iserror(&eq_v)) {
+			return eq_v;
+		}
+
+		if (!glow_boolvalue(&eq_v)) {
+			goto neq;
 		}
 	}
 
@@ -317,35 +406,24 @@ size_t glow_dict_len(GlowDictObject *dict)
 	return dict->count;
 }
 
-static Entry **make_empty_table(const size_t capacity)
-{
-	Entry **table = glow_malloc(capacity * sizeof(Entry *));
-	for (size_t i = 0; i < capacity; i++) {
-		table[i] = NULL;
-	}
-	return table;
-}
-
+/* moves the live items to a new table, compacting them */
 static void dict_resize(GlowDictObject *dict, const size_t new_capacity)
 {
-	const size_t old_capacity = dict->capacity;
-	Entry **old_entries = dict->entries;
-	Entry **new_entries = make_empty_table(new_capacity);
-
-	for (size_t i = 0; i < old_capacity; i++) {
-		Entry *entry = old_entries[i];
-		while (entry != NULL) {
-			Entry *next = entry->next;
-			const size_t idx = entry->hash & (new_capacity - 1);
-			entry->next = new_entries[idx];
-			new_entries[idx] = entry;
-			entry = next;
+	void *old_indices = dict->indices;
+	Entry *old_entries = dict->entries;
+	const size_t old_n_entries = dict->n_entries;
+
+	table_init(dict, new_capacity);
+
+	for (size_t i = 0; i < old_n_entries; i++) {
+		Entry *entry = &old_entries[i];
+
+		if (!glow_isempty(&entry->key)) {
+			insert_new(dict, &entry->key, &entry->value, entry->hash);
 		}
 	}
 
-	free(old_entries);
-	dict->entries = new_entries;
-	dict->capacity = new_capacity;
+	free(old_indices);
 	++dict->state_id;
 }
 
@@ -406,8 +484,6 @@ static GlowValue dict_str(GlowValue *this)
 	GlowDictObject *dict = glow_objvalue(this);
 	GLOW_ENTER(dict);
 
-	const size_t capacity = dict->capacity;
-
 	if (dict->count == 0) {
 		GLOW_EXIT(dict);
 		return glow_strobj_make_direct("{}", 2);
@@ -417,52 +493,57 @@ static GlowValue dict_str(GlowValue *this)
 	glow_strbuf_init(&sb, 16);
 	glow_strbuf_append(&sb, "{", 1);
 
-	Entry **entries = dict->entries;
-
 	bool first = true;
-	for (size_t i = 0; i < capacity; i++) {
-		for (Entry *e = entries[i]; e != NULL; e = e->next) {
-			if (!first) {
-				glow_strbuf_append(&sb, ", ", 2);
-			}
-			first = false;
+	for (size_t i = 0; i < dict->n_entries; i++) {
+		/* re-read each time, as str() may change the dict */
+		Entry *e = &dict->entries[i];
 
-			GlowValue *key = &e->key;
-			GlowValue *value = &e->value;
+		if (glow_isempty(&e->key)) {
+			continue;
+		}
 
-			if (glow_isobject(key) && glow_objvalue(key) == dict) {
-				glow_strbuf_append(&sb, "{...}", 5);
-			} else {
-				GlowValue str_v = glow_op_str(key);
+		if (!first) {
+			glow_strbuf_append(&sb, ", ", 2);
+		}
+		first = false;
+
+		GlowValue key_v = e->key;
+		GlowValue value_v = e->value;
+		GlowValue *key = &key_v;
+		GlowValue *value = &value_v;
 
-				if (glow_iserror(&str_v)) {
-					glow_strbuf_dealloc(&sb);
-					GLOW_EXIT(dict);
-					return str_v;
-				}
+		if (glow_isobject(key) && glow_objvalue(key) == dict) {
+			glow_strbuf_append(&sb, "{...}", 5);
+		} else {
+			GlowValue str_v = glow_op_str(key);
 
-				GlowStrObject *str = glow_objvalue(&str_v);
-				glow_strbuf_append(&sb, str->str.value, str->str.len);
-				glow_releaseo(str);
+			if (glow_iserror(&str_v)) {
+				glow_strbuf_dealloc(&sb);
+				GLOW_EXIT(dict);
+				return str_v;
 			}
 
-			glow_strbuf_append(&sb, ": ", 2);
+			GlowStrObject *str = glow_objvalue(&str_v);
+			glow_strbuf_append(&sb, str->str.value, str->str.len);
+			glow_releaseo(str);
+		}
 
-			if (glow_isobject(value) && glow_objvalue(value) == dict) {
-				glow_strbuf_append(&sb, "{...}", 5);
-			} else {
-				GlowValue str_v = glow_op_str(value);
+		glow_strbuf_append(&sb, ": ", 2);
 
-				if (glow_iserror(&str_v)) {
-					glow_strbuf_dealloc(&sb);
-					GLOW_EXIT(dict);
-					return str_v;
-				}
+		if (glow_isobject(value) && glow_objvalue(value) == dict) {
+			glow_strbuf_append(&sb, "{...}", 5);
+		} else {
+			GlowValue str_v = glow_op_str(value);
 
-				GlowStrObject *str = glow_objvalue(&str_v);
-				glow_strbuf_append(&sb, str->str.value, str->str.len);
-				glow_releaseo(str);
+			if (glow_iserror(&str_v)) {
+				glow_strbuf_dealloc(&sb);
+				GLOW_EXIT(dict);
+				return str_v;
 			}
+
+			GlowStrObject *str = glow_objvalue(&str_v);
+			glow_strbuf_append(&sb, str->str.value, str->str.len);
+			glow_releaseo(str);
 		}
 	}
 	glow_strbuf_append(&sb, "}", 1);
@@ -546,25 +627,46 @@ static GlowValue dict_remove_method(GlowValue *this,
 #undef NAME
 }
 
+static void free_table(void *indices, Entry *entries, const size_t n_entries)
+{
+	for (size_t i = 0; i < n_entries; i++) {
+		glow_release(&entries[i].key);
+		glow_release(&entries[i].value);
+	}
+
+	free(indices);
+}
+
 static void dict_free(GlowValue *this)
 {
 	GlowDictObject *dict = glow_objvalue(this);
-	Entry **entries = dict->entries;
-	const size_t capacity = dict->capacity;
+	free_table(dict->indices, dict->entries, dict->n_entries);
+	glow_obj_class.del(this);
+}
 
-	for (size_t i = 0; i < capacity; i++) {
-		Entry *entry = entries[i];
-		while (entry != NULL) {
-			Entry *temp = entry;
-			entry = entry->next;
-			glow_release(&temp->key);
-			glow_release(&temp->value);
-			free(temp);
-		}
+static void dict_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowDictObject *dict = glow_objvalue(this);
+	Entry *entries = dict->entries;
+	const size_t n_entries = dict->n_entries;
+
+	for (size_t i = 0; i < n_entries; i++) {
+		visit(&entries[i].key, arg);
+		visit(&entries[i].value, arg);
 	}
+}
 
-	free(entries);
-	glow_obj_class.del(this);
+static void dict_clear(GlowValue *this)
+{
+	GlowDictObject *dict = glow_objvalue(this);
+	void *indices = dict->indices;
+	Entry *entries = dict->entries;
+	const size_t n_entries = dict->n_entries;
+
+	table_init(dict, EMPTY_SIZE);
+	++dict->state_id;
+
+	free_table(indices, entries, n_entries);
 }
 
 struct glow_num_methods glow_dict_num_methods = {
@@ -644,6 +746,9 @@ GlowClass glow_dict_class = {
 	.init = NULL,
 	.del = dict_free,
 
+	.traverse = dict_traverse,
+	.clear = dict_clear,
+
 	.eq = dict_eq,
 	.hash = NULL,
 	.cmp = NULL,
@@ -674,7 +779,6 @@ static GlowValue iter_make(GlowDictObject *dict)
 	glow_retaino(dict);
 	iter->source = dict;
 	iter->saved_state_id = dict->state_id;
-	iter->current_entry = NULL;
 	iter->current_index = 0;
 	return glow_makeobj(iter);
 }
@@ -689,37 +793,26 @@ static GlowValue iter_next(GlowValue *this)
 		return GLOW_ISC_EXC("dict changed state during iteration");
 	}
 
-	Entry **entries = iter->source->entries;
-	Entry *entry = iter->current_entry;
+	Entry *entries = iter->source->entries;
+	const size_t n_entries = iter->source->n_entries;
 	size_t idx = iter->current_index;
-	const size_t capacity = iter->source->capacity;
 
-	if (idx >= capacity) {
-		GLOW_EXIT(iter->source);
-		return glow_get_iter_stop();
+	while (idx < n_entries && glow_isempty(&entries[idx].key)) {
+		++idx;
 	}
 
-	if (entry == NULL) {
-		for (size_t i = idx; i < capacity; i++) {
-			if (entries[i] != NULL) {
-				entry = entries[i];
-				idx = i+1;
-				break;
-			}
-		}
-
-		if (entry == NULL) {
-			GLOW_EXIT(iter->source);
-			return glow_get_iter_stop();
-		}
+	if (idx >= n_entries) {
+		iter->current_index = idx;
+		GLOW_EXIT(iter->source);
+		return glow_get_iter_stop();
 	}
 
+	Entry *entry = &entries[idx];
 	GlowValue pair[] = {entry->key, entry->value};
 	glow_retain(&pair[0]);
 	glow_retain(&pair[1]);
 
-	iter->current_index = idx;
-	iter->current_entry = entry->next;
+	iter->current_index = idx + 1;
 
 	GLOW_EXIT(iter->source);
 	return glow_tuple_make(pair, 2);
@@ -22,10 +22,10 @@
 
 #define FLOAT_IBINOP_FUNC_BODY(op) \
 	if (glow_isint(other)) { \
-		glow_floatvalue(this) = glow_floatvalue(this) op glow_intvalue(other); \
+		*this = glow_makefloat(glow_floatvalue(this) op glow_intvalue(other)); \
 		return *this; \
 	} else if (glow_isfloat(other)) { \
-		glow_floatvalue(this) = glow_floatvalue(this) op glow_floatvalue(other); \
+		*this = glow_makefloat(glow_floatvalue(this) op glow_floatvalue(other)); \
 		return *this; \
 	} else { \
 		return glow_makeut(); \
@@ -44,7 +44,7 @@ static GlowValue float_eq(GlowValue *this, GlowValue *other)
 
 static GlowValue float_hash(GlowValue *this)
 {
-	return glow_makeint(glow_util_hash_double(glow_floatvalue(this)));
+	return glow_makehash(glow_util_hash_double(glow_floatvalue(this)));
 }
 
 static GlowValue float_cmp(GlowValue *this, GlowValue *other)
@@ -130,10 +130,10 @@ static GlowValue float_idiv(GlowValue *this, GlowValue *other)
 static GlowValue float_ipow(GlowValue *this, GlowValue *other)
 {
 	if (glow_isint(other)) {
-		glow_floatvalue(this) = pow(glow_floatvalue(this), glow_intvalue(other));
+		*this = glow_makefloat(pow(glow_floatvalue(this), glow_intvalue(other)));
 		return *this;
 	} else if (glow_isfloat(other)) {
-		glow_floatvalue(this) = pow(glow_floatvalue(this), glow_floatvalue(other));
+		*this = glow_makefloat(pow(glow_floatvalue(this), glow_floatvalue(other)));
 		return *this;
 	} else {
 		return glow_makeut();
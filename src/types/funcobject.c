@@ -8,6 +8,7 @@
 #include "strobject.h"
 #include "vm.h"
 #include "util.h"
+#include "gc.h"
 #include "exc.h"
 #include "err.h"
 #include "codeobject.h"
@@ -21,6 +22,7 @@ GlowValue glow_funcobj_make(GlowCodeObject *co)
 	glow_retaino(co);
 	fn->co = co;
 	fn->defaults = (struct glow_value_array){.array = NULL, .length = 0};
+	glow_gc_track(fn);
 	return glow_makeobj(fn);
 }
 
@@ -60,6 +62,56 @@ static void release_defaults(GlowFuncObject *fn)
 	fn->defaults = (struct glow_value_array){.array = NULL, .length = 0};
 }
 
+static void funcobj_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowFuncObject *fn = glow_objvalue(this);
+	const size_t n_defaults = fn->defaults.length;
+
+	for (size_t i = 0; i < n_defaults; i++) {
+		visit(&fn->defaults.array[i], arg);
+	}
+}
+
+static void funcobj_clear(GlowValue *this)
+{
+	release_defaults(glow_objvalue(this));
+}
+
+/*
+ * Pushes a frame for a call of `fn` onto the call stack of `vm`, binding
+ * the arguments directly into the frame's locals. On failure, nothing is
+ * pushed and the resulting exception is returned.
+ */
+GlowValue glow_funcobj_push_frame(GlowVM *vm,
+                                GlowFuncObject *fn,
+                                GlowValue *args,
+                                GlowValue *args_named,
+                                size_t nargs,
+                                size_t nargs_named)
+{
+	GlowCodeObject *co = fn->co;
+
+	glow_retaino(co);
+	glow_vm_push_frame(vm, co);
+	GlowValue status = glow_codeobj_load_args(co,
+	                                          &fn->defaults,
+	                                          args,
+	                                          args_named,
+	                                          nargs,
+	                                          nargs_named,
+	                                          vm->callstack->locals);
+
+	if (glow_iserror(&status)) {
+		glow_vm_pop_frame(vm);
+	}
+
+	return status;
+}
+
+/*
+ * Note that the VM runs calls made by the CALL instruction inline (see
+ * glow_vm_eval_frame()), so this is only used for calls from native code.
+ */
 static GlowValue funcobj_call(GlowValue *this,
                              GlowValue *args,
                              GlowValue *args_named,
@@ -67,29 +119,18 @@ static GlowValue funcobj_call(GlowValue *this,
                              size_t nargs_named)
 {
 	GlowFuncObject *fn = glow_objvalue(this);
-	GlowCodeObject *co = fn->co;
 	GlowVM *vm = glow_current_vm_get();
-	const unsigned int argcount = co->argcount;
-
-	GlowValue *locals = glow_calloc(argcount, sizeof(GlowValue));
-	GlowValue status = glow_codeobj_load_args(co, &fn->defaults, args, args_named, nargs, nargs_named, locals);
+	GlowValue status = glow_funcobj_push_frame(vm, fn, args, args_named, nargs, nargs_named);
 
 	if (glow_iserror(&status)) {
-		free(locals);
 		return status;
 	}
 
-	glow_retaino(co);
-	glow_vm_push_frame(vm, co);
 	GlowFrame *top = vm->callstack;
-	memcpy(top->locals, locals, argcount * sizeof(GlowValue));
-	free(locals);
 	glow_vm_eval_frame(vm);
 	GlowValue res = top->return_value;
 	glow_vm_pop_frame(vm);
 	return res;
-
-#undef RELEASE_ALL
 }
 
 struct glow_num_methods fn_num_methods = {
@@ -162,6 +203,9 @@ GlowClass glow_fn_class = {
 	.init = NULL,
 	.del = funcobj_free,
 
+	.traverse = funcobj_traverse,
+	.clear = funcobj_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
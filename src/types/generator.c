@@ -7,6 +7,7 @@
 #include "exc.h"
 #include "vm.h"
 #include "util.h"
+#include "gc.h"
 #include "generator.h"
 
 GlowValue glow_gen_proxy_make(GlowCodeObject *co)
@@ -15,6 +16,7 @@ GlowValue glow_gen_proxy_make(GlowCodeObject *co)
 	glow_retaino(co);
 	gp->co = co;
 	gp->defaults = (struct glow_value_array){.array = NULL, .length = 0};
+	glow_gc_track(gp);
 	return glow_makeobj(gp);
 }
 
@@ -30,6 +32,7 @@ GlowValue glow_gen_make(GlowGeneratorProxy *gp)
 	glow_retaino(co);
 	go->co = gp->co;
 	go->frame = frame;
+	glow_gc_track(go);
 	return glow_makeobj(go);
 }
 
@@ -79,6 +82,53 @@ static void release_defaults(GlowGeneratorProxy *gp)
 	gp->defaults = (struct glow_value_array){.array = NULL, .length = 0};
 }
 
+static void gen_proxy_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowGeneratorProxy *gp = glow_objvalue(this);
+	const size_t n_defaults = gp->defaults.length;
+
+	for (size_t i = 0; i < n_defaults; i++) {
+		visit(&gp->defaults.array[i], arg);
+	}
+}
+
+static void gen_proxy_clear(GlowValue *this)
+{
+	release_defaults(glow_objvalue(this));
+}
+
+/* only a suspended generator's frame is looked at */
+static void gen_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowGeneratorObject *go = glow_objvalue(this);
+	GlowFrame *frame = go->frame;
+
+	if (frame == NULL || frame->active) {
+		return;
+	}
+
+	for (size_t i = 0; i < frame->n_locals; i++) {
+		visit(&frame->locals[i], arg);
+	}
+
+	for (GlowValue *v = frame->val_stack_base; v != frame->val_stack; v++) {
+		visit(v, arg);
+	}
+
+	visit(&frame->return_value, arg);
+}
+
+static void gen_clear(GlowValue *this)
+{
+	GlowGeneratorObject *go = glow_objvalue(this);
+	GlowFrame *frame = go->frame;
+
+	if (frame != NULL && !frame->active) {
+		go->frame = NULL;
+		glow_frame_free(frame);
+	}
+}
+
 static GlowValue gen_proxy_call(GlowValue *this,
                                GlowValue *args,
                                GlowValue *args_named,
@@ -152,6 +202,9 @@ GlowClass glow_gen_proxy_class = {
 	.init = NULL,
 	.del = gen_proxy_free,
 
+	.traverse = gen_proxy_traverse,
+	.clear = gen_proxy_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
@@ -183,6 +236,9 @@ GlowClass glow_gen_class = {
 	.init = NULL,
 	.del = gen_free,
 
+	.traverse = gen_traverse,
+	.clear = gen_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
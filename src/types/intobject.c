@@ -29,11 +29,10 @@
 
 #define INT_IBINOP_FUNC_BODY(op) \
 	if (glow_isint(other)) { \
-		glow_intvalue(this) = glow_intvalue(this) op glow_intvalue(other); \
+		*this = glow_makeint(glow_intvalue(this) op glow_intvalue(other)); \
 		return *this; \
 	} else if (glow_isfloat(other)) { \
-		this->type = GLOW_VAL_TYPE_FLOAT; \
-		glow_floatvalue(this) = glow_intvalue(this) op glow_floatvalue(other); \
+		*this = glow_makefloat(glow_intvalue(this) op glow_floatvalue(other)); \
 		return *this; \
 	} else { \
 		return glow_makeut(); \
@@ -41,7 +40,7 @@
 
 #define INT_IBINOP_FUNC_BODY_NOFLOAT(op) \
 	if (glow_isint(other)) { \
-		glow_intvalue(this) = glow_intvalue(this) op glow_intvalue(other); \
+		*this = glow_makeint(glow_intvalue(this) op glow_intvalue(other)); \
 		return *this; \
 	} else { \
 		return glow_makeut(); \
@@ -60,7 +59,7 @@ static GlowValue int_eq(GlowValue *this, GlowValue *other)
 
 static GlowValue int_hash(GlowValue *this)
 {
-	return glow_makeint(glow_util_hash_long(glow_intvalue(this)));
+	return glow_makehash(glow_util_hash_long(glow_intvalue(this)));
 }
 
 static GlowValue int_cmp(GlowValue *this, GlowValue *other)
@@ -198,11 +197,10 @@ static GlowValue int_imod(GlowValue *this, GlowValue *other)
 static GlowValue int_ipow(GlowValue *this, GlowValue *other)
 {
 	if (glow_isint(other)) {
-		glow_intvalue(this) = pow(glow_intvalue(this), glow_intvalue(other));
+		*this = glow_makeint(pow(glow_intvalue(this), glow_intvalue(other)));
 		return *this;
 	} else if (glow_isfloat(other)) {
-		this->type = GLOW_VAL_TYPE_FLOAT;
-		glow_floatvalue(this) = pow(glow_intvalue(this), glow_floatvalue(other));
+		*this = glow_makefloat(pow(glow_intvalue(this), glow_floatvalue(other)));
 		return *this;
 	} else {
 		return glow_makeut();
@@ -7,6 +7,7 @@
 #include "object.h"
 #include "strobject.h"
 #include "util.h"
+#include "gc.h"
 #include "listobject.h"
 
 static GlowValue iter_make(GlowListObject *list);
@@ -31,6 +32,7 @@ GlowValue glow_list_make(GlowValue *elements, const size_t count)
 	list->count = count;
 	list->capacity = count;
 
+	glow_gc_track(list);
 	return glow_makeobj(list);
 }
 
@@ -100,6 +102,22 @@ static void list_free(GlowValue *this)
 	glow_obj_class.del(this);
 }
 
+static void list_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowListObject *list = glow_objvalue(this);
+	GlowValue *elements = list->elements;
+	const size_t count = list->count;
+
+	for (size_t i = 0; i < count; i++) {
+		visit(&elements[i], arg);
+	}
+}
+
+static void list_clear(GlowValue *this)
+{
+	glow_list_clear(glow_objvalue(this));
+}
+
 static GlowValue list_len(GlowValue *this)
 {
 	GlowListObject *list = glow_objvalue(this);
@@ -431,6 +449,9 @@ GlowClass glow_list_class = {
 	.init = NULL,
 	.del = list_free,
 
+	.traverse = list_traverse,
+	.clear = list_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
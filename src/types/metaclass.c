@@ -6,6 +6,8 @@
 #include "exc.h"
 #include "object.h"
 #include "strobject.h"
+#include "nativefunc.h"
+#include "vmops.h"
 #include "metaclass.h"
 
 static void meta_class_del(GlowValue *this)
@@ -52,16 +54,31 @@ static GlowValue meta_class_call(GlowValue *this,
 	GlowValue init_result = init(&instance, args, nargs);
 
 	if (glow_iserror(&init_result)) {
-		free(glow_objvalue(&instance));  /* straight-up free; no need to
-		                                   go through `release` since we can
-		                                   be sure nobody has a reference to
-		                                   the newly created instance        */
+		glow_obj_dealloc(glow_objvalue(&instance));  /* straight-up free; no need to
+		                                               go through `release` since we can
+		                                               be sure nobody has a reference to
+		                                               the newly created instance        */
 		return init_result;
 	} else {
 		return instance;
 	}
 }
 
+static GlowValue meta_class_attr_get(GlowValue *this, const char *attr)
+{
+	GlowClass *class = glow_objvalue(this);
+
+	if (class->statics != NULL) {
+		for (struct glow_attr_static *s = class->statics; s->name != NULL; s++) {
+			if (strcmp(s->name, attr) == 0) {
+				return glow_makeobj(s->func);
+			}
+		}
+	}
+
+	return glow_op_get_attr_default(this, attr);
+}
+
 GlowClass glow_meta_class = {
 	.base = GLOW_CLASS_BASE_INIT(),
 	.name = "MetaClass",
@@ -89,6 +106,6 @@ GlowClass glow_meta_class = {
 	.members = NULL,
 	.methods = NULL,
 
-	.attr_get = NULL,
+	.attr_get = meta_class_attr_get,
 	.attr_set = NULL
 };
@@ -23,20 +23,32 @@ static void module_free(GlowValue *this)
 	glow_obj_class.del(this);
 }
 
-static GlowValue module_attr_get(GlowValue *this, const char *attr)
+static void builtin_module_init(GlowBuiltInModule *mod);
+
+GlowValue glow_module_get_attr(GlowValue *this, GlowStr *attr)
 {
 	GlowModule *mod = glow_objvalue(this);
-	GlowStr key = GLOW_STR_INIT(attr, strlen(attr), 0);
-	GlowValue v = glow_strdict_get(&mod->contents, &key);
+
+	if (glow_getclass(this) == &glow_builtin_module_class) {
+		builtin_module_init((GlowBuiltInModule *)mod);
+	}
+
+	GlowValue v = glow_strdict_get(&mod->contents, attr);
 
 	if (glow_isempty(&v)) {
-		return glow_attr_exc_not_found(&glow_module_class, attr);
+		return glow_attr_exc_not_found(&glow_module_class, attr->value);
 	}
 
 	glow_retain(&v);
 	return v;
 }
 
+static GlowValue module_attr_get(GlowValue *this, const char *attr)
+{
+	GlowStr key = GLOW_STR_INIT(attr, strlen(attr), 0);
+	return glow_module_get_attr(this, &key);
+}
+
 static GlowValue module_attr_set(GlowValue *this, const char *attr, GlowValue *v)
 {
 	GLOW_UNUSED(attr);
@@ -138,23 +150,23 @@ GlowClass glow_module_class = {
 
 static void builtin_module_init(GlowBuiltInModule *mod)
 {
+	if (mod->initialized) {
+		return;
+	}
+
 	GlowStrDict *dict = &mod->base.contents;
+	glow_strdict_init(dict);
+
 	const struct glow_builtin *members = mod->members;
 	for (size_t i = 0; members[i].name != NULL; i++) {
 		glow_strdict_put(dict, members[i].name, (GlowValue *)&members[i].value, false);
 	}
+
+	mod->initialized = true;
 }
 
 static GlowValue builtin_module_attr_get(GlowValue *this, const char *attr)
 {
-	GlowBuiltInModule *mod = glow_objvalue(this);
-
-	if (!mod->initialized) {
-		glow_strdict_init(&mod->base.contents);
-		builtin_module_init(mod);
-		mod->initialized = true;
-	}
-
 	return glow_module_class.attr_get(this, attr);
 }
 
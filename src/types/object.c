@@ -11,6 +11,8 @@
 #include "floatobject.h"
 #include "strobject.h"
 #include "exc.h"
+#include "slab.h"
+#include "gc.h"
 #include "object.h"
 
 static GlowValue obj_init(GlowValue *this, GlowValue *args, size_t nargs)
@@ -55,7 +57,7 @@ static bool obj_nonzero(GlowValue *this)
 
 static void obj_free(GlowValue *this)
 {
-	free(glow_objvalue(this));
+	glow_obj_dealloc(glow_objvalue(this));
 }
 
 struct glow_num_methods obj_num_methods = {
@@ -155,7 +157,7 @@ GlowClass *glow_getclass(GlowValue *v)
 		return NULL;
 	}
 
-	switch (v->type) {
+	switch (glow_valtype(v)) {
 	case GLOW_VAL_TYPE_NULL:
 		return &glow_null_class;
 	case GLOW_VAL_TYPE_BOOL:
@@ -205,48 +207,6 @@ bool glow_is_subclass(GlowClass *child, GlowClass *parent)
 	return false;
 }
 
-#define MAKE_METHOD_RESOLVER_DIRECT(name, type) \
-type glow_resolve_##name(GlowClass *class) { \
-	GlowClass *target = class; \
-	type op; \
-	while (target != NULL && (op = target->name) == NULL) { \
-		if (target == target->super) { \
-			return glow_obj_class.name; \
-		} \
-		target = target->super; \
-	} \
-\
-	if (target == NULL) { \
-		return glow_obj_class.name; \
-	} \
-\
-	class->name = op; \
-	return op; \
-}
-
-#define MAKE_METHOD_RESOLVER(name, category, type) \
-type glow_resolve_##name(GlowClass *class) { \
-	if (class->category == NULL) { \
-		return glow_obj_class.category->name; \
-	} \
-\
-	GlowClass *target = class; \
-	type op; \
-	while (target != NULL && (op = target->category->name) == NULL) { \
-		if (target == target->super) { \
-			return glow_obj_class.category->name; \
-		} \
-		target = target->super; \
-	} \
-\
-	if (target == NULL) { \
-		return glow_obj_class.category->name; \
-	} \
-\
-	class->category->name = op; \
-	return op; \
-}
-
 /*
  * Initializers should not be inherited.
  */
@@ -263,67 +223,348 @@ GlowDelFunc glow_resolve_del(GlowClass *class)
 	return class->del;
 }
 
-MAKE_METHOD_RESOLVER_DIRECT(eq, GlowBinOp)
-MAKE_METHOD_RESOLVER_DIRECT(hash, GlowUnOp)
-MAKE_METHOD_RESOLVER_DIRECT(cmp, GlowBinOp)
-MAKE_METHOD_RESOLVER_DIRECT(str, GlowUnOp)
-MAKE_METHOD_RESOLVER_DIRECT(call, GlowCallFunc)
-MAKE_METHOD_RESOLVER_DIRECT(print, GlowPrintFunc)
-MAKE_METHOD_RESOLVER_DIRECT(iter, GlowUnOp)
-MAKE_METHOD_RESOLVER_DIRECT(iternext, GlowUnOp)
-MAKE_METHOD_RESOLVER_DIRECT(attr_get, GlowAttrGetFunc)
-MAKE_METHOD_RESOLVER_DIRECT(attr_set, GlowAttrSetFunc)
-
-MAKE_METHOD_RESOLVER(plus, num_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(minus, num_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(abs, num_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(add, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(sub, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(mul, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(div, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(mod, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(pow, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(bitnot, num_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(bitand, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(bitor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(xor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(shiftl, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(shiftr, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(iadd, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(isub, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(imul, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(idiv, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(imod, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ipow, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ibitand, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ibitor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ixor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ishiftl, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(ishiftr, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(radd, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rsub, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rmul, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rdiv, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rmod, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rpow, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rbitand, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rbitor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rxor, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rshiftl, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(rshiftr, num_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(nonzero, num_methods, BoolUnOp)
-MAKE_METHOD_RESOLVER(to_int, num_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(to_float, num_methods, GlowUnOp)
-
-MAKE_METHOD_RESOLVER(len, seq_methods, GlowUnOp)
-MAKE_METHOD_RESOLVER(get, seq_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(set, seq_methods, GlowSeqSetFunc)
-MAKE_METHOD_RESOLVER(contains, seq_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(apply, seq_methods, GlowBinOp)
-MAKE_METHOD_RESOLVER(iapply, seq_methods, GlowBinOp)
-
-#undef MAKE_METHOD_RESOLVER_DIRECT
-#undef MAKE_METHOD_RESOLVER
+atomic_uint glow_vtable_epoch = 1;
+static pthread_mutex_t vtable_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define VTABLE_HAS_direct(class)            true
+#define VTABLE_HAS_num_methods(class)       ((class)->num_methods != NULL)
+#define VTABLE_HAS_seq_methods(class)       ((class)->seq_methods != NULL)
+#define VTABLE_SLOT_direct(class, name)       ((class)->name)
+#define VTABLE_SLOT_num_methods(class, name)  (VTABLE_HAS_num_methods(class) ? (class)->num_methods->name : NULL)
+#define VTABLE_SLOT_seq_methods(class, name)  (VTABLE_HAS_seq_methods(class) ? (class)->seq_methods->name : NULL)
+
+/*
+ * Resolves a slot by walking up the class hierarchy, falling back
+ * to `glow_obj_class`. A class with no num/seq methods at all gets
+ * the `glow_obj_class` defaults for that category.
+ */
+#define VTABLE_RESOLVE(name, category, type) \
+	vt->name = NULL; \
+	if (VTABLE_HAS_##category(class)) { \
+		for (GlowClass *target = class; target != NULL; target = target->super) { \
+			if ((vt->name = VTABLE_SLOT_##category(target, name)) != NULL || target == target->super) { \
+				break; \
+			} \
+		} \
+	} \
+	if (vt->name == NULL) { \
+		vt->name = VTABLE_SLOT_##category(&glow_obj_class, name); \
+	}
+
+static void vtable_fill(GlowClass *class)
+{
+	struct glow_vtable *vt = &class->vtable;
+	GLOW_VTABLE_SLOTS(VTABLE_RESOLVE)
+}
+
+#undef VTABLE_RESOLVE
+#undef VTABLE_SLOT_seq_methods
+#undef VTABLE_SLOT_num_methods
+#undef VTABLE_SLOT_direct
+#undef VTABLE_HAS_seq_methods
+#undef VTABLE_HAS_num_methods
+#undef VTABLE_HAS_direct
+
+/*
+ * Slow path of glow_class_vtable(): (re)builds the class's flattened
+ * vtable for the current epoch.
+ */
+const struct glow_vtable *glow_class_vtable_build(GlowClass *class)
+{
+	GLOW_SAFE(pthread_mutex_lock(&vtable_mutex));
+	const unsigned int epoch = atomic_load(&glow_vtable_epoch);
+
+	if (atomic_load_explicit(&class->vtable_epoch, memory_order_relaxed) != epoch) {
+		vtable_fill(class);
+		atomic_store_explicit(&class->vtable_epoch, epoch, memory_order_release);
+	}
+
+	GLOW_SAFE(pthread_mutex_unlock(&vtable_mutex));
+	return &class->vtable;
+}
+
+/*
+ * Forces every class to rebuild its vtable on next use; called
+ * whenever new classes (e.g. from plugins) may have been registered.
+ */
+void glow_class_invalidate_vtables(void)
+{
+	atomic_fetch_add(&glow_vtable_epoch, 1);
+}
+
+/*
+ * Biased reference counting
+ *
+ * `shared_refcnt` holds the shared count times RC_ONE plus two flags:
+ * RC_MERGED once the owner's biased count has been folded into it (from
+ * then on it is the whole count and every thread updates it atomically)
+ * and RC_QUEUED while the object waits in its owner's merge queue.
+ *
+ * A thread that drives the shared count of an unmerged object below zero
+ * has released a reference its owner counted, so the object may already
+ * be garbage. It is queued for the owner, which merges it at its next
+ * safe point (glow_refcnt_merge_pending()). Once the owner has exited
+ * its biased counts can no longer change, so its objects are merged on
+ * the spot instead.
+ *
+ * Owners are threads, or the tasks they run (see scheduler.h). The IDs
+ * of exited owners are reused, and whoever reuses one takes over the
+ * biased counts of the objects its last holder left behind; it has to
+ * wait for any merges begun while the ID was dead to finish first.
+ */
+
+#define RC_MERGED 1
+#define RC_QUEUED 2
+#define RC_FLAGS  (RC_MERGED | RC_QUEUED)
+#define RC_ONE    4
+
+struct rc_thread {
+	pthread_mutex_t mutex;
+	GlowObject **queue;
+	size_t queue_size;
+	size_t queue_capacity;
+	atomic_bool pending;
+	bool dead;
+	unsigned int merging;  /* merges by others since `dead` */
+	unsigned int next_free;
+};
+
+#define RC_THREADS_CHUNK_SIZE 256
+#define RC_THREADS_MAX_CHUNKS 256
+
+static struct rc_thread *_Atomic rc_threads[RC_THREADS_MAX_CHUNKS];
+static pthread_mutex_t rc_threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int rc_next_tid = 1;
+static unsigned int rc_free_tids = GLOW_OWNER_NONE;  /* linked through `next_free` */
+
+_Thread_local unsigned int glow_current_owner = GLOW_OWNER_UNASSIGNED;
+
+static struct rc_thread *rc_thread_get(const unsigned int tid);
+
+/* takes an exited owner's ID once nobody is merging its objects anymore */
+static unsigned int rc_thread_reuse(void)
+{
+	for (unsigned int *link = &rc_free_tids; *link != GLOW_OWNER_NONE;) {
+		const unsigned int tid = *link;
+		struct rc_thread *t = rc_thread_get(tid);
+
+		GLOW_SAFE(pthread_mutex_lock(&t->mutex));
+		const bool idle = (t->merging == 0);
+		if (idle) {
+			t->dead = false;
+		}
+		GLOW_SAFE(pthread_mutex_unlock(&t->mutex));
+
+		if (idle) {
+			*link = t->next_free;
+			return tid;
+		}
+
+		link = &t->next_free;
+	}
+
+	return GLOW_OWNER_NONE;
+}
+
+static unsigned int rc_thread_register(void)
+{
+	GLOW_SAFE(pthread_mutex_lock(&rc_threads_mutex));
+	unsigned int tid = rc_thread_reuse();
+
+	if (tid != GLOW_OWNER_NONE) {
+		GLOW_SAFE(pthread_mutex_unlock(&rc_threads_mutex));
+		glow_current_owner = tid;
+		return tid;
+	}
+
+	tid = rc_next_tid;
+	const unsigned int chunk = tid / RC_THREADS_CHUNK_SIZE;
+
+	if (chunk < RC_THREADS_MAX_CHUNKS) {
+		if (atomic_load_explicit(&rc_threads[chunk], memory_order_relaxed) == NULL) {
+			struct rc_thread *threads = glow_calloc(RC_THREADS_CHUNK_SIZE, sizeof(struct rc_thread));
+
+			for (size_t i = 0; i < RC_THREADS_CHUNK_SIZE; i++) {
+				GLOW_SAFE(pthread_mutex_init(&threads[i].mutex, NULL));
+			}
+
+			atomic_store_explicit(&rc_threads[chunk], threads, memory_order_release);
+		}
+
+		++rc_next_tid;
+	} else {
+		/* out of IDs: objects made by this thread start out shared */
+		tid = GLOW_OWNER_NONE;
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&rc_threads_mutex));
+
+	glow_current_owner = tid;
+	return tid;
+}
+
+static struct rc_thread *rc_thread_get(const unsigned int tid)
+{
+	struct rc_thread *threads = atomic_load_explicit(&rc_threads[tid / RC_THREADS_CHUNK_SIZE],
+	                                                 memory_order_acquire);
+	return &threads[tid % RC_THREADS_CHUNK_SIZE];
+}
+
+/*
+ * Folds the owner's count into the shared count. Must be called by the
+ * owner on an unmerged object. Returns whether the object is now dead.
+ */
+static bool rc_merge(GlowObject *o)
+{
+	if (o->class->traverse != NULL) {
+		glow_gc_untrack(o);  /* only the owner may collect it */
+	}
+
+	atomic_store_explicit(&o->owner, GLOW_OWNER_SHARED, memory_order_relaxed);
+	const int delta = (int)o->refcnt * RC_ONE + RC_MERGED;
+	o->refcnt = 0;
+	const int new = atomic_fetch_add_explicit(&o->shared_refcnt, delta, memory_order_acq_rel) + delta;
+	return new == RC_MERGED;
+}
+
+/*
+ * Merges (if need be) and dequeues an object whose RC_QUEUED flag is
+ * held by the caller. Called by the owner, or by anyone once the owner
+ * has exited, in which case several threads may race to merge.
+ */
+static void rc_merge_queued(GlowObject *o)
+{
+	int old = atomic_load_explicit(&o->shared_refcnt, memory_order_relaxed);
+	int new;
+
+	do {
+		new = old & ~RC_QUEUED;
+
+		if (!(old & RC_MERGED)) {
+			new += (int)o->refcnt * RC_ONE + RC_MERGED;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&o->shared_refcnt, &old, new,
+	                                                memory_order_acq_rel, memory_order_relaxed));
+
+	if (!(old & RC_MERGED)) {
+		atomic_store_explicit(&o->owner, GLOW_OWNER_SHARED, memory_order_relaxed);
+
+		if (o->class->traverse != NULL) {
+			glow_gc_untrack(o);
+		}
+	}
+
+	if (new == RC_MERGED) {
+		glow_destroyo(o);
+	}
+}
+
+static void rc_queue(GlowObject *o, const unsigned int owner)
+{
+	int old = atomic_load_explicit(&o->shared_refcnt, memory_order_relaxed);
+
+	do {
+		if (old >= 0 || (old & RC_FLAGS)) {
+			return;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&o->shared_refcnt, &old, old | RC_QUEUED,
+	                                                memory_order_acq_rel, memory_order_relaxed));
+
+	struct rc_thread *t = rc_thread_get(owner);
+	GLOW_SAFE(pthread_mutex_lock(&t->mutex));
+	const bool dead = t->dead;
+
+	if (dead) {
+		++t->merging;
+	} else {
+		if (t->queue_size == t->queue_capacity) {
+			t->queue_capacity = t->queue_capacity ? 2*t->queue_capacity : 16;
+			t->queue = glow_realloc(t->queue, t->queue_capacity * sizeof(GlowObject *));
+		}
+
+		t->queue[t->queue_size++] = o;
+		atomic_store_explicit(&t->pending, true, memory_order_release);
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&t->mutex));
+
+	if (dead) {
+		rc_merge_queued(o);
+
+		GLOW_SAFE(pthread_mutex_lock(&t->mutex));
+		--t->merging;
+		GLOW_SAFE(pthread_mutex_unlock(&t->mutex));
+	}
+}
+
+/* returns whether the queue was empty */
+static bool rc_drain(struct rc_thread *t, const bool exiting)
+{
+	GLOW_SAFE(pthread_mutex_lock(&t->mutex));
+	GlowObject **queue = t->queue;
+	const size_t queue_size = t->queue_size;
+	t->queue = NULL;
+	t->queue_size = 0;
+	t->queue_capacity = 0;
+	atomic_store_explicit(&t->pending, false, memory_order_relaxed);
+
+	if (exiting && queue_size == 0) {
+		t->dead = true;
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&t->mutex));
+
+	for (size_t i = 0; i < queue_size; i++) {
+		rc_merge_queued(queue[i]);
+	}
+
+	free(queue);
+	return queue_size == 0;
+}
+
+/*
+ * Merges objects other threads have queued for this one. Threads that
+ * own objects should call this at safe points, e.g. on message passing.
+ */
+void glow_refcnt_merge_pending(void)
+{
+	const unsigned int tid = glow_current_owner;
+
+	if (tid == GLOW_OWNER_UNASSIGNED || tid == GLOW_OWNER_NONE) {
+		return;
+	}
+
+	struct rc_thread *t = rc_thread_get(tid);
+
+	if (atomic_load_explicit(&t->pending, memory_order_acquire)) {
+		rc_drain(t, false);
+	}
+}
+
+/* must be the last thing a thread (or task) that may own objects does */
+void glow_refcnt_thread_exit(void)
+{
+	const unsigned int tid = glow_current_owner;
+
+	if (tid == GLOW_OWNER_UNASSIGNED || tid == GLOW_OWNER_NONE) {
+		return;
+	}
+
+	struct rc_thread *t = rc_thread_get(tid);
+	while (!rc_drain(t, true));
+
+	GLOW_SAFE(pthread_mutex_lock(&rc_threads_mutex));
+	t->next_free = rc_free_tids;
+	rc_free_tids = tid;
+	GLOW_SAFE(pthread_mutex_unlock(&rc_threads_mutex));
+
+	glow_current_owner = GLOW_OWNER_UNASSIGNED;
+}
+
+/* makes the calling thread act as `owner`; returns the owner it acted as */
+unsigned int glow_refcnt_owner_swap(const unsigned int owner)
+{
+	const unsigned int prev = glow_current_owner;
+	glow_current_owner = owner;
+	return prev;
+}
 
 void *glow_obj_alloc(GlowClass *class)
 {
@@ -332,13 +573,56 @@ void *glow_obj_alloc(GlowClass *class)
 
 void *glow_obj_alloc_var(GlowClass *class, size_t extra)
 {
-	GlowObject *o = glow_malloc(class->instance_size + extra);
+	const size_t head_size = (class->traverse != NULL) ? sizeof(struct glow_gc_head) : 0;
+	const size_t size = head_size + class->instance_size + extra;
+	const unsigned int size_class = glow_slab_size_class(size);
+	char *block = (size_class > 0) ? glow_slab_alloc(size_class) : glow_malloc(size);
+	GlowObject *o = (GlowObject *)(block + head_size);
+	unsigned int tid = glow_current_owner;
+
+	if (head_size > 0) {
+		glow_gc_head_init(GLOW_GC_HEAD(o));
+	}
+
+	if (tid == GLOW_OWNER_UNASSIGNED) {
+		tid = rc_thread_register();
+	}
+
 	o->class = class;
-	o->refcnt = 1;
+
+	if (tid != GLOW_OWNER_NONE) {
+		atomic_init(&o->owner, tid);
+		o->refcnt = 1;
+		atomic_init(&o->shared_refcnt, 0);
+	} else {
+		atomic_init(&o->owner, GLOW_OWNER_SHARED);
+		o->refcnt = 0;
+		atomic_init(&o->shared_refcnt, RC_ONE | RC_MERGED);
+	}
+
 	o->monitor = 0;
+	o->size_class = size_class;
 	return o;
 }
 
+/* frees the memory of an object allocated by glow_obj_alloc() */
+void glow_obj_dealloc(void *p)
+{
+	GlowObject *o = p;
+	void *block = o;
+
+	if (o->class->traverse != NULL) {
+		glow_gc_untrack(o);
+		block = GLOW_GC_HEAD(o);
+	}
+
+	if (o->size_class > 0) {
+		glow_slab_free(block);
+	} else {
+		free(block);
+	}
+}
+
 GlowValue glow_class_instantiate(GlowClass *class, GlowValue *args, size_t nargs)
 {
 	if (class == &glow_null_class) {
@@ -363,25 +647,63 @@ GlowValue glow_class_instantiate(GlowClass *class, GlowValue *args, size_t nargs
 void glow_retaino(void *p)
 {
 	GlowObject *o = p;
-	if (o->refcnt != (unsigned)(-1)) {
-		GLOW_UNUSED(++o->refcnt);
+	const unsigned int owner = atomic_load_explicit(&o->owner, memory_order_relaxed);
+
+	if (owner == glow_current_owner) {
+		++o->refcnt;
+	} else if (owner != GLOW_OWNER_IMMORTAL) {
+		atomic_fetch_add_explicit(&o->shared_refcnt, RC_ONE, memory_order_relaxed);
 	}
 }
 
 void glow_releaseo(void *p)
 {
 	GlowObject *o = p;
-	if (o->refcnt != (unsigned)(-1) && --o->refcnt == 0) {
-		glow_destroyo(o);
+	const unsigned int owner = atomic_load_explicit(&o->owner, memory_order_relaxed);
+
+	if (owner == glow_current_owner) {
+		if (--o->refcnt == 0 && rc_merge(o)) {
+			glow_destroyo(o);
+		}
+	} else if (owner != GLOW_OWNER_IMMORTAL) {
+		const int new = atomic_fetch_sub_explicit(&o->shared_refcnt, RC_ONE, memory_order_acq_rel) - RC_ONE;
+
+		if (new == RC_MERGED) {
+			glow_destroyo(o);
+		} else if (new < 0 && !(new & RC_FLAGS)) {
+			rc_queue(o, owner);
+		}
 	}
 }
 
 void glow_destroyo(void *p)
 {
 	GlowObject *o = p;
+
+	/* keep collections away from half-destroyed containers */
+	if (o->class->traverse != NULL) {
+		glow_gc_untrack(o);
+	}
+
 	o->class->del(&glow_makeobj(o));
 }
 
+/* whether the calling thread owns (and alone counts references to) `o` */
+bool glow_obj_is_local(void *p)
+{
+	GlowObject *o = p;
+	const unsigned int tid = glow_current_owner;
+	return tid != GLOW_OWNER_UNASSIGNED && atomic_load_explicit(&o->owner, memory_order_relaxed) == tid;
+}
+
+/* total reference count of an object local to the calling thread */
+long glow_obj_local_refcnt(void *p)
+{
+	GlowObject *o = p;
+	const int shared = atomic_load_explicit(&o->shared_refcnt, memory_order_relaxed);
+	return (long)o->refcnt + (shared & ~RC_FLAGS) / RC_ONE;
+}
+
 void glow_retain(GlowValue *v)
 {
 	if (v == NULL || !(glow_isobject(v) || glow_isexc(v))) {
@@ -398,13 +720,99 @@ void glow_release(GlowValue *v)
 	glow_releaseo(glow_objvalue(v));
 }
 
-void glow_destroy(GlowValue *v)
+struct share_stack {
+	GlowObject **objs;
+	size_t size;
+	size_t capacity;
+};
+
+static void share_push(struct share_stack *stack, GlowObject *o)
+{
+	if (stack->size == stack->capacity) {
+		stack->capacity = stack->capacity ? 2*stack->capacity : 16;
+		stack->objs = glow_realloc(stack->objs, stack->capacity * sizeof(GlowObject *));
+	}
+
+	stack->objs[stack->size++] = o;
+}
+
+/*
+ * Only tracked containers are walked into: untracked ones have had
+ * their contents shared already, or (like started actors) are no
+ * longer the owner's to look inside of.
+ */
+static inline bool share_walks(GlowObject *o)
+{
+	return o->class->traverse != NULL && GLOW_GC_HEAD(o)->next != NULL;
+}
+
+static void share_visit(GlowValue *v, void *arg)
 {
-	if (v == NULL || v->type != GLOW_VAL_TYPE_OBJECT) {
+	if (!glow_isobject(v)) {
 		return;
 	}
+
 	GlowObject *o = glow_objvalue(v);
-	o->class->del(v);
+
+	if (atomic_load_explicit(&o->owner, memory_order_relaxed) == glow_current_owner && share_walks(o)) {
+		share_push(arg, o);
+	}
+}
+
+/*
+ * Marks an object as about to be handed to another thread, so that from
+ * now on all threads (including its owner) count references atomically.
+ * Containers it reaches are shared along with it, so that the owner's
+ * cycle collector no longer looks at any of them. Only has an effect
+ * when called by the owner.
+ */
+void glow_shareo(void *p)
+{
+	GlowObject *o = p;
+
+	if (atomic_load_explicit(&o->owner, memory_order_relaxed) != glow_current_owner) {
+		return;
+	}
+
+	const bool walk = share_walks(o);
+
+	/* caller holds a reference, and containers hold their contents, so none is ever dead */
+	GLOW_UNUSED(rc_merge(o));
+
+	if (!walk) {
+		return;
+	}
+
+	struct share_stack stack = {.objs = NULL, .size = 0, .capacity = 0};
+	o->class->traverse(&glow_makeobj(o), share_visit, &stack);
+
+	while (stack.size > 0) {
+		o = stack.objs[--stack.size];
+
+		/* may have been reached twice */
+		if (atomic_load_explicit(&o->owner, memory_order_relaxed) == glow_current_owner) {
+			GLOW_UNUSED(rc_merge(o));
+			o->class->traverse(&glow_makeobj(o), share_visit, &stack);
+		}
+	}
+
+	free(stack.objs);
+}
+
+void glow_share(GlowValue *v)
+{
+	if (v == NULL || !(glow_isobject(v) || glow_isexc(v))) {
+		return;
+	}
+	glow_shareo(glow_objvalue(v));
+}
+
+void glow_destroy(GlowValue *v)
+{
+	if (v == NULL || !glow_isobject(v)) {
+		return;
+	}
+	glow_destroyo(glow_objvalue(v));
 }
 
 void glow_class_init(GlowClass *class)
@@ -427,6 +835,8 @@ void glow_class_init(GlowClass *class)
 	glow_attr_dict_init(&class->attr_dict, max_size);
 	glow_attr_dict_register_members(&class->attr_dict, class->members);
 	glow_attr_dict_register_methods(&class->attr_dict, class->methods);
+
+	glow_class_vtable_build(class);
 }
 
 static pthread_mutex_t monitor_management_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -461,7 +871,11 @@ static void free_monitors(void)
 
 bool glow_object_set_monitor(GlowObject *o)
 {
-	if (o->refcnt > 1 || o->monitor != 0) {
+	const bool unique = atomic_load_explicit(&o->owner, memory_order_relaxed) == glow_current_owner &&
+	                    o->refcnt == 1 &&
+	                    atomic_load_explicit(&o->shared_refcnt, memory_order_relaxed) == 0;
+
+	if (!unique || o->monitor != 0) {
 		return false;
 	}
 
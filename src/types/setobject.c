@@ -9,164 +9,335 @@
 #include "strobject.h"
 #include "iter.h"
 #include "util.h"
+#include "gc.h"
 #include "setobject.h"
 
-#define EMPTY_SIZE  16
-#define LOAD_FACTOR 0.75f
+/*
+ * Swiss table: open addressing over groups of GROUP_WIDTH slots, each
+ * slot having a control byte that is either EMPTY, DELETED or (for a
+ * full slot) a 7-bit tag of the element's hash. A probe looks at a
+ * whole group at once, comparing all its control bytes against the
+ * hash in one go, so `eq` is only called on likely matches. The low
+ * hash bits pick the first group (as glow_util_hash_secondary() is made
+ * for masking); further groups are probed triangularly. With SSE2 a
+ * group is matched with a single vector compare.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define GROUP_WIDTH GLOW_SET_GROUP_WIDTH
+#define EMPTY_SIZE  GROUP_WIDTH
+
+/* control bytes; EMPTY and DELETED have the sign bit set */
+#define CTRL_EMPTY   ((signed char)-128)
+#define CTRL_DELETED ((signed char)-2)
+
+/* group index, and the 7-bit tag kept in the control byte (top bits of a Fibonacci hash) */
+#define H1(hash) ((unsigned int)(hash))
+#define H2(hash) ((signed char)(((unsigned int)(hash) * 0x9e3779b1u) >> 25))
+
+/* max. load factor of 7/8 */
+#define MAX_LOAD(cap) ((cap) - (cap) / 8)
 
 typedef struct glow_set_entry Entry;
 
-static Entry **make_empty_table(const size_t capacity);
 static void set_resize(GlowSetObject *set, const size_t new_capacity);
 static void set_free_entries(GlowSetObject *set);
 static void set_free(GlowValue *this);
 
-GlowValue glow_set_make(GlowValue *elements, const size_t size)
+/* bitmask of the slots of a group whose control byte is `c` */
+static inline unsigned int group_match(const signed char *group, const signed char c)
 {
-	GlowSetObject *set = glow_obj_alloc(&glow_set_class);
-	GLOW_INIT_SAVED_TID_FIELD(set);
-
-	const size_t capacity = (size == 0) ? EMPTY_SIZE : glow_smallest_pow_2_at_least(size);
-
-	set->entries = make_empty_table(capacity);
-	set->count = 0;
-	set->capacity = capacity;
-	set->threshold = (size_t)(capacity * LOAD_FACTOR);
-	set->state_id = 0;
+#if defined(__SSE2__)
+	const __m128i ctrl = _mm_load_si128((const __m128i *)group);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned int)(group[i] == c) << i;
+	}
+	return mask;
+#endif
+}
 
-	for (size_t i = 0; i < size; i++) {
-		GlowValue *value = &elements[i];
-		GlowValue v = glow_set_add(set, value);
+static inline unsigned int group_match_empty_or_deleted(const signed char *group)
+{
+#if defined(__SSE2__)
+	return (unsigned int)_mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+#else
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned int)(group[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
 
-		if (glow_iserror(&v)) {
-			GlowValue set_v = glow_makeobj(set);
-			set_free(&set_v);
+static inline unsigned int lowest_bit(const unsigned int mask)
+{
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctz(mask);
+#else
+	unsigned int i = 0;
+	while (!(mask & (1u << i))) {
+		++i;
+	}
+	return i;
+#endif
+}
 
-			for (size_t j = i; j < size; j++) {
-				glow_release(&elements[j]);
-			}
+/* smallest capacity with room for `n` elements */
+static size_t capacity_for(const size_t n)
+{
+	size_t capacity = EMPTY_SIZE;
+	while (MAX_LOAD(capacity) < n) {
+		capacity <<= 1;
+	}
+	return capacity;
+}
 
-			return v;
-		}
+/* sets up an empty table; control bytes and slots share one allocation */
+static void table_init(GlowSetObject *set, const size_t capacity)
+{
+	/* `capacity` is a multiple of GROUP_WIDTH, so both parts stay aligned */
+	signed char *table = aligned_alloc(GROUP_WIDTH, capacity + capacity * sizeof(Entry));
 
-		glow_release(value);
+	if (table == NULL) {
+		GLOW_INTERNAL_ERROR();
 	}
 
-	return glow_makeobj(set);
+	memset(table, CTRL_EMPTY, capacity);
+	set->ctrl = table;
+	set->slots = (Entry *)(table + capacity);
+	set->count = 0;
+	set->capacity = capacity;
+	set->growth_left = MAX_LOAD(capacity);
 }
 
-static Entry *make_entry(GlowValue *element, const int hash)
+static inline bool same_element(GlowValue *a, GlowValue *b)
 {
-	Entry *entry = glow_malloc(sizeof(Entry));
-	entry->element = *element;
-	entry->hash = hash;
-	entry->next = NULL;
-	return entry;
+	if (glow_isobject(a)) {
+		return glow_isobject(b) && glow_objvalue(a) == glow_objvalue(b);
+	}
+
+	return glow_isint(a) && glow_isint(b) && glow_intvalue(a) == glow_intvalue(b);
 }
 
-GlowValue glow_set_add(GlowSetObject *set, GlowValue *element)
+/*
+ * Returns the slot holding `element`, or -1 if there is none. An error
+ * raised by `eq` is stored in `error`, with -1 being returned.
+ */
+static long find(GlowSetObject *set, GlowValue *element, const int hash, GlowValue *error)
 {
-	Entry **entries = set->entries;
-	const size_t capacity = set->capacity;
-	const GlowValue hash_v = glow_op_hash(element);
+	GlowBinOp eq = NULL;
+	const size_t group_mask = set->capacity / GROUP_WIDTH - 1;
+	size_t g = H1(hash) & group_mask;
 
-	if (glow_iserror(&hash_v)) {
-		return hash_v;
-	}
+	for (size_t step = 1; true; step++) {
+		const signed char *group = &set->ctrl[g * GROUP_WIDTH];
 
-	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
-	const size_t index = hash & (capacity - 1);
+		for (unsigned int m = group_match(group, H2(hash)); m != 0; m &= m - 1) {
+			const size_t i = g * GROUP_WIDTH + lowest_bit(m);
+			Entry *entry = &set->slots[i];
+
+			if (entry->hash != hash) {
+				continue;
+			}
 
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(element));
+			if (same_element(element, &entry->element)) {
+				return (long)i;
+			}
 
-	for (Entry *entry = entries[index];
-	     entry != NULL;
-	     entry = entry->next) {
+			/* every value should have a valid `eq` */
+			if (eq == NULL) {
+				eq = glow_resolve_eq(glow_getclass(element));
+			}
 
-		if (hash == entry->hash) {
 			GlowValue eq_v = eq(element, &entry->element);
 
 			if (glow_iserror(&eq_v)) {
-				return eq_v;
+				*error = eq_v;
+				return -1;
 			}
 
 			if (glow_boolvalue(&eq_v)) {
-				return glow_makefalse();
+				return (long)i;
 			}
 		}
+
+		if (group_match(group, CTRL_EMPTY) != 0) {
+			return -1;
+		}
+
+		g = (g + step) & group_mask;
 	}
+}
 
-	glow_retain(element);
+static size_t find_insert_slot(GlowSetObject *set, const int hash)
+{
+	const size_t group_mask = set->capacity / GROUP_WIDTH - 1;
+	size_t g = H1(hash) & group_mask;
 
-	Entry *entry = make_entry(element, hash);
-	entry->next = entries[index];
-	entries[index] = entry;
+	for (size_t step = 1; true; step++) {
+		const unsigned int m = group_match_empty_or_deleted(&set->ctrl[g * GROUP_WIDTH]);
 
-	if (set->count++ >= set->threshold) {
-		const size_t new_capacity = (2 * capacity);
-		set_resize(set, new_capacity);
-		set->threshold = (size_t)(new_capacity * LOAD_FACTOR);
+		if (m != 0) {
+			return g * GROUP_WIDTH + lowest_bit(m);
+		}
+
+		g = (g + step) & group_mask;
 	}
+}
 
-	++set->state_id;
-	return glow_maketrue();
+/* adds an element known not to be in the set, stealing the reference; there must be room */
+static void insert_new(GlowSetObject *set, GlowValue *element, const int hash)
+{
+	const size_t i = find_insert_slot(set, hash);
+
+	if (set->ctrl[i] == CTRL_EMPTY) {
+		--set->growth_left;
+	}
+
+	set->ctrl[i] = H2(hash);
+	set->slots[i].element = *element;
+	set->slots[i].hash = hash;
+	++set->count;
 }
 
-GlowValue glow_set_remove(GlowSetObject *set, GlowValue *element)
+/* makes room for `n` more elements */
+static void reserve(GlowSetObject *set, const size_t n)
+{
+	if (set->growth_left < n) {
+		set_resize(set, capacity_for(set->count + n));
+	}
+}
+
+static void erase(GlowSetObject *set, const size_t i)
+{
+	/*
+	 * A group with an empty slot never had a probe pass through it, so
+	 * the slot can become empty again rather than a tombstone.
+	 */
+	const signed char *group = &set->ctrl[i - i % GROUP_WIDTH];
+
+	if (group_match(group, CTRL_EMPTY) != 0) {
+		set->ctrl[i] = CTRL_EMPTY;
+		++set->growth_left;
+	} else {
+		set->ctrl[i] = CTRL_DELETED;
+	}
+
+	glow_release(&set->slots[i].element);
+	--set->count;
+}
+
+static bool hash_element(GlowValue *element, int *hash, GlowValue *error)
 {
 	const GlowValue hash_v = glow_op_hash(element);
 
 	if (glow_iserror(&hash_v)) {
-		return hash_v;
+		*error = hash_v;
+		return false;
 	}
 
-	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
+	*hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
+	return true;
+}
 
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(element));
+/* adds an element with a known hash; returns true if added, false if present, or an error */
+static GlowValue add_hashed(GlowSetObject *set, GlowValue *element, const int hash)
+{
+	GlowValue error = glow_makeempty();
 
-	Entry **entries = set->entries;
-	const size_t idx = hash & (set->capacity - 1);
-	Entry *entry = entries[idx];
-	Entry *prev = entry;
+	if (find(set, element, hash, &error) >= 0) {
+		return glow_makefalse();
+	}
 
-	while (entry != NULL) {
-		Entry *next = entry->next;
+	if (glow_iserror(&error)) {
+		return error;
+	}
 
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(element, &entry->element);
+	if (set->growth_left == 0) {
+		set_resize(set, capacity_for(2 * (set->count + 1)));
+	}
 
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	glow_retain(element);
+	insert_new(set, element, hash);
+	++set->state_id;
+	return glow_maketrue();
+}
 
-			if (glow_boolvalue(&eq_v)) {
-				if (prev == entry) {
-					entries[idx] = next;
-				} else {
-					prev->next = next;
-				}
+static GlowSetObject *set_alloc(const size_t capacity)
+{
+	GlowSetObject *set = glow_obj_alloc(&glow_set_class);
+	GLOW_INIT_SAVED_TID_FIELD(set);
+	table_init(set, capacity);
+	set->state_id = 0;
+	return set;
+}
+
+GlowValue glow_set_make(GlowValue *elements, const size_t size)
+{
+	GlowSetObject *set = set_alloc(capacity_for(size));
+
+	for (size_t i = 0; i < size; i++) {
+		GlowValue *value = &elements[i];
+		GlowValue v = glow_set_add(set, value);
 
-				glow_release(&entry->element);
-				free(entry);
-				--set->count;
-				++set->state_id;
-				return glow_maketrue();
+		if (glow_iserror(&v)) {
+			GlowValue set_v = glow_makeobj(set);
+			set_free(&set_v);
+
+			for (size_t j = i; j < size; j++) {
+				glow_release(&elements[j]);
 			}
+
+			return v;
 		}
 
-		prev = entry;
-		entry = next;
+		glow_release(value);
+	}
+
+	glow_gc_track(set);
+	return glow_makeobj(set);
+}
+
+GlowValue glow_set_add(GlowSetObject *set, GlowValue *element)
+{
+	int hash;
+	GlowValue error;
+
+	if (!hash_element(element, &hash, &error)) {
+		return error;
+	}
+
+	return add_hashed(set, element, hash);
+}
+
+GlowValue glow_set_remove(GlowSetObject *set, GlowValue *element)
+{
+	int hash;
+	GlowValue error = glow_makeempty();
+
+	if (!hash_element(element, &hash, &error)) {
+		return error;
+	}
+
+	const long i = find(set, element, hash, &error);
+
+	if (i < 0) {
+		return glow_iserror(&error) ? error : glow_makefalse();
 	}
 
-	return glow_makefalse();
+	erase(set, (size_t)i);
+	++set->state_id;
+	return glow_maketrue();
 }
 
 GlowValue glow_set_contains(GlowSetObject *set, GlowValue *element)
 {
-	Entry **entries = set->entries;
-	const size_t capacity = set->capacity;
 	GlowValue hash_v = glow_op_hash(element);
 
 	if (glow_iserror(&hash_v)) {
@@ -175,103 +346,218 @@ GlowValue glow_set_contains(GlowSetObject *set, GlowValue *element)
 	}
 
 	const int hash = glow_util_hash_secondary(glow_intvalue(&hash_v));
-	const size_t index = hash & (capacity - 1);
+	GlowValue error = glow_makeempty();
+	const long i = find(set, element, hash, &error);
 
-	/* every value should have a valid `eq` */
-	const GlowBinOp eq = glow_resolve_eq(glow_getclass(element));
+	if (glow_iserror(&error)) {
+		return error;
+	}
 
-	for (Entry *entry = entries[index];
-	     entry != NULL;
-	     entry = entry->next) {
+	return glow_makebool(i >= 0);
+}
 
-		if (hash == entry->hash) {
-			GlowValue eq_v = eq(element, &entry->element);
+GlowValue glow_set_eq(GlowSetObject *set, GlowSetObject *other)
+{
+	if (set->count != other->count) {
+		return glow_makefalse();
+	}
 
-			if (glow_iserror(&eq_v)) {
-				return eq_v;
-			}
+	const size_t capacity = set->capacity;
 
-			if (glow_boolvalue(&eq_v)) {
-				return glow_maketrue();
-			}
+	for (size_t i = 0; i < capacity; i++) {
+		if (set->ctrl[i] < 0) {
+			continue;
+		}
+
+		Entry *entry = &set->slots[i];
+		GlowValue error = glow_makeempty();
+
+		if (find(other, &entry->element, entry->hash, &error) < 0) {
+			return glow_iserror(&error) ? error : glow_makefalse();
 		}
 	}
 
-	return glow_makefalse();
+	return glow_maketrue();
 }
 
-GlowValue glow_set_eq(GlowSetObject *set, GlowSetObject *other)
+size_t glow_set_len(GlowSetObject *set)
 {
-	if (set->count != other->count) {
-		return glow_makefalse();
-	}
+	return set->count;
+}
 
-	GlowSetObject *s1, *s2;
+/* a new set holding the elements of `set` */
+static GlowSetObject *set_copy(GlowSetObject *set, const size_t extra)
+{
+	if (extra > set->growth_left) {
+		GlowSetObject *copy = set_alloc(capacity_for(set->count + extra));
+		const size_t capacity = set->capacity;
+
+		for (size_t i = 0; i < capacity; i++) {
+			if (set->ctrl[i] >= 0) {
+				glow_retain(&set->slots[i].element);
+				insert_new(copy, &set->slots[i].element, set->slots[i].hash);
+			}
+		}
 
-	if (set->capacity < other->capacity) {
-		s1 = set;
-		s2 = other;
-	} else {
-		s1 = other;
-		s2 = set;
+		return copy;
 	}
 
-	Entry **entries = s1->entries;
-	size_t capacity = s1->capacity;
+	/* same layout, so the table can be copied as is */
+	GlowSetObject *copy = set_alloc(set->capacity);
+	const size_t capacity = set->capacity;
+	memcpy(copy->ctrl, set->ctrl, capacity + capacity * sizeof(Entry));
+	copy->count = set->count;
+	copy->growth_left = set->growth_left;
+
 	for (size_t i = 0; i < capacity; i++) {
-		for (Entry *entry = entries[i];
-		     entry != NULL;
-		     entry = entry->next) {
+		if (copy->ctrl[i] >= 0) {
+			glow_retain(&copy->slots[i].element);
+		}
+	}
 
-			GlowValue contains = glow_set_contains(s2, &entry->element);
+	return copy;
+}
 
-			if (glow_iserror(&contains)) {
-				return contains;
-			}
+/* adds the elements of `other` to `set`; `set` may be left partially updated on error */
+static GlowValue set_update(GlowSetObject *set, GlowSetObject *other)
+{
+	reserve(set, other->count);
+	const size_t capacity = other->capacity;
 
-			if (!glow_boolvalue(&contains)) {
-				return glow_makefalse();
-			}
+	for (size_t i = 0; i < capacity; i++) {
+		if (other->ctrl[i] < 0) {
+			continue;
+		}
+
+		GlowValue v = add_hashed(set, &other->slots[i].element, other->slots[i].hash);
+
+		if (glow_iserror(&v)) {
+			return v;
 		}
 	}
 
-	return glow_maketrue();
+	return glow_makenull();
 }
 
-size_t glow_set_len(GlowSetObject *set)
+GlowValue glow_set_union(GlowSetObject *set, GlowSetObject *other)
 {
-	return set->count;
+	GlowSetObject *larger = (set->count >= other->count) ? set : other;
+	GlowSetObject *smaller = (larger == set) ? other : set;
+	GlowSetObject *result = set_copy(larger, smaller->count);
+	GlowValue result_v = glow_makeobj(result);
+	GlowValue v = set_update(result, smaller);
+
+	if (glow_iserror(&v)) {
+		set_free(&result_v);
+		return v;
+	}
+
+	glow_gc_track(result);
+	return result_v;
 }
 
-static Entry **make_empty_table(const size_t capacity)
+GlowValue glow_set_intersection(GlowSetObject *set, GlowSetObject *other)
 {
-	Entry **table = glow_malloc(capacity * sizeof(Entry *));
+	GlowSetObject *larger = (set->count >= other->count) ? set : other;
+	GlowSetObject *smaller = (larger == set) ? other : set;
+	GlowSetObject *result = set_alloc(capacity_for(smaller->count));
+	GlowValue result_v = glow_makeobj(result);
+	const size_t capacity = smaller->capacity;
+
 	for (size_t i = 0; i < capacity; i++) {
-		table[i] = NULL;
+		if (smaller->ctrl[i] < 0) {
+			continue;
+		}
+
+		Entry *entry = &smaller->slots[i];
+		GlowValue error = glow_makeempty();
+
+		if (find(larger, &entry->element, entry->hash, &error) >= 0) {
+			glow_retain(&entry->element);
+			insert_new(result, &entry->element, entry->hash);
+		} else if (glow_iserror(&error)) {
+			set_free(&result_v);
+			return error;
+		}
+	}
+
+	glow_gc_track(result);
+	return result_v;
+}
+
+GlowValue glow_set_difference(GlowSetObject *set, GlowSetObject *other)
+{
+	GlowSetObject *result;
+	GlowValue result_v;
+
+	if (other->count < set->count) {
+		/* copy `set` and drop what `other` has */
+		result = set_copy(set, 0);
+		result_v = glow_makeobj(result);
+		const size_t capacity = other->capacity;
+
+		for (size_t i = 0; i < capacity; i++) {
+			if (other->ctrl[i] < 0) {
+				continue;
+			}
+
+			Entry *entry = &other->slots[i];
+			GlowValue error = glow_makeempty();
+			const long j = find(result, &entry->element, entry->hash, &error);
+
+			if (j >= 0) {
+				erase(result, (size_t)j);
+			} else if (glow_iserror(&error)) {
+				set_free(&result_v);
+				return error;
+			}
+		}
+	} else {
+		/* keep what `other` doesn't have */
+		result = set_alloc(capacity_for(set->count));
+		result_v = glow_makeobj(result);
+		const size_t capacity = set->capacity;
+
+		for (size_t i = 0; i < capacity; i++) {
+			if (set->ctrl[i] < 0) {
+				continue;
+			}
+
+			Entry *entry = &set->slots[i];
+			GlowValue error = glow_makeempty();
+
+			if (find(other, &entry->element, entry->hash, &error) < 0) {
+				if (glow_iserror(&error)) {
+					set_free(&result_v);
+					return error;
+				}
+
+				glow_retain(&entry->element);
+				insert_new(result, &entry->element, entry->hash);
+			}
+		}
 	}
-	return table;
+
+	glow_gc_track(result);
+	return result_v;
 }
 
+/* rehashes the elements into a new table, dropping tombstones */
 static void set_resize(GlowSetObject *set, const size_t new_capacity)
 {
+	signed char *old_ctrl = set->ctrl;
+	Entry *old_slots = set->slots;
 	const size_t old_capacity = set->capacity;
-	Entry **old_entries = set->entries;
-	Entry **new_entries = make_empty_table(new_capacity);
+
+	table_init(set, new_capacity);
 
 	for (size_t i = 0; i < old_capacity; i++) {
-		Entry *entry = old_entries[i];
-		while (entry != NULL) {
-			Entry *next = entry->next;
-			const size_t idx = entry->hash & (new_capacity - 1);
-			entry->next = new_entries[idx];
-			new_entries[idx] = entry;
-			entry = next;
+		if (old_ctrl[i] >= 0) {
+			insert_new(set, &old_slots[i].element, old_slots[i].hash);
 		}
 	}
 
-	free(old_entries);
-	set->entries = new_entries;
-	set->capacity = new_capacity;
+	free(old_ctrl);
 	++set->state_id;
 }
 
@@ -325,33 +611,33 @@ static GlowValue set_str(GlowValue *this)
 	glow_strbuf_init(&sb, 16);
 	glow_strbuf_append(&sb, "{", 1);
 
-	Entry **entries = set->entries;
-
 	bool first = true;
 	for (size_t i = 0; i < capacity; i++) {
-		for (Entry *e = entries[i]; e != NULL; e = e->next) {
-			if (!first) {
-				glow_strbuf_append(&sb, ", ", 2);
-			}
-			first = false;
+		if (set->ctrl[i] < 0) {
+			continue;
+		}
 
-			GlowValue *element = &e->element;
+		if (!first) {
+			glow_strbuf_append(&sb, ", ", 2);
+		}
+		first = false;
 
-			if (glow_isobject(element) && glow_objvalue(element) == set) {
-				glow_strbuf_append(&sb, "{...}", 5);
-			} else {
-				GlowValue str_v = glow_op_str(element);
+		GlowValue *element = &set->slots[i].element;
 
-				if (glow_iserror(&str_v)) {
-					glow_strbuf_dealloc(&sb);
-					GLOW_EXIT(set);
-					return str_v;
-				}
+		if (glow_isobject(element) && glow_objvalue(element) == set) {
+			glow_strbuf_append(&sb, "{...}", 5);
+		} else {
+			GlowValue str_v = glow_op_str(element);
 
-				GlowStrObject *str = glow_objvalue(&str_v);
-				glow_strbuf_append(&sb, str->str.value, str->str.len);
-				glow_releaseo(str);
+			if (glow_iserror(&str_v)) {
+				glow_strbuf_dealloc(&sb);
+				GLOW_EXIT(set);
+				return str_v;
 			}
+
+			GlowStrObject *str = glow_objvalue(&str_v);
+			glow_strbuf_append(&sb, str->str.value, str->str.len);
+			glow_releaseo(str);
 		}
 	}
 	glow_strbuf_append(&sb, "}", 1);
@@ -414,6 +700,102 @@ static GlowValue set_remove_method(GlowValue *this,
 #undef NAME
 }
 
+static GlowValue set_union_method(GlowValue *this,
+                                  GlowValue *args,
+                                  GlowValue *args_named,
+                                  size_t nargs,
+                                  size_t nargs_named)
+{
+#define NAME "union"
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	if (!glow_is_a(&args[0], &glow_set_class)) {
+		return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[0]));
+	}
+
+	GlowSetObject *set = glow_objvalue(this);
+	GlowSetObject *other = glow_objvalue(&args[0]);
+	GLOW_ENTER(set);
+	GlowValue ret = glow_set_union(set, other);
+	GLOW_EXIT(set);
+	return ret;
+#undef NAME
+}
+
+static GlowValue set_intersection_method(GlowValue *this,
+                                         GlowValue *args,
+                                         GlowValue *args_named,
+                                         size_t nargs,
+                                         size_t nargs_named)
+{
+#define NAME "intersection"
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	if (!glow_is_a(&args[0], &glow_set_class)) {
+		return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[0]));
+	}
+
+	GlowSetObject *set = glow_objvalue(this);
+	GlowSetObject *other = glow_objvalue(&args[0]);
+	GLOW_ENTER(set);
+	GlowValue ret = glow_set_intersection(set, other);
+	GLOW_EXIT(set);
+	return ret;
+#undef NAME
+}
+
+static GlowValue set_difference_method(GlowValue *this,
+                                       GlowValue *args,
+                                       GlowValue *args_named,
+                                       size_t nargs,
+                                       size_t nargs_named)
+{
+#define NAME "difference"
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	if (!glow_is_a(&args[0], &glow_set_class)) {
+		return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[0]));
+	}
+
+	GlowSetObject *set = glow_objvalue(this);
+	GlowSetObject *other = glow_objvalue(&args[0]);
+	GLOW_ENTER(set);
+	GlowValue ret = glow_set_difference(set, other);
+	GLOW_EXIT(set);
+	return ret;
+#undef NAME
+}
+
+static GlowValue set_update_method(GlowValue *this,
+                                   GlowValue *args,
+                                   GlowValue *args_named,
+                                   size_t nargs,
+                                   size_t nargs_named)
+{
+#define NAME "update"
+	GLOW_UNUSED(args_named);
+	GLOW_NO_NAMED_ARGS_CHECK(NAME, nargs_named);
+	GLOW_ARG_COUNT_CHECK(NAME, nargs, 1);
+
+	if (!glow_is_a(&args[0], &glow_set_class)) {
+		return glow_type_exc_unsupported_1(NAME, glow_getclass(&args[0]));
+	}
+
+	GlowSetObject *set = glow_objvalue(this);
+	GlowSetObject *other = glow_objvalue(&args[0]);
+	GLOW_ENTER(set);
+	GlowValue ret = set_update(set, other);
+	GLOW_EXIT(set);
+	return ret;
+#undef NAME
+}
+
 static GlowValue set_init(GlowValue *this, GlowValue *args, size_t nargs)
 {
 	GLOW_ARG_COUNT_CHECK_AT_MOST("Set", nargs, 1);
@@ -421,10 +803,7 @@ static GlowValue set_init(GlowValue *this, GlowValue *args, size_t nargs)
 
 	GlowSetObject *set = glow_objvalue(this);
 	GLOW_INIT_SAVED_TID_FIELD(set);
-	set->entries = make_empty_table(EMPTY_SIZE);
-	set->count = 0;
-	set->capacity = EMPTY_SIZE;
-	set->threshold = (size_t)(EMPTY_SIZE * LOAD_FACTOR);
+	table_init(set, EMPTY_SIZE);
 	set->state_id = 0;
 
 	if (nargs > 0) {
@@ -459,25 +838,24 @@ static GlowValue set_init(GlowValue *this, GlowValue *args, size_t nargs)
 		glow_release(&iter);
 	}
 
+	glow_gc_track(set);
 	return *this;
 }
 
-static void set_free_entries(GlowSetObject *set)
+static void free_table(signed char *ctrl, Entry *slots, const size_t capacity)
 {
-	Entry **entries = set->entries;
-	const size_t capacity = set->capacity;
-
 	for (size_t i = 0; i < capacity; i++) {
-		Entry *entry = entries[i];
-		while (entry != NULL) {
-			Entry *temp = entry;
-			entry = entry->next;
-			glow_release(&temp->element);
-			free(temp);
+		if (ctrl[i] >= 0) {
+			glow_release(&slots[i].element);
 		}
 	}
 
-	free(entries);
+	free(ctrl);
+}
+
+static void set_free_entries(GlowSetObject *set)
+{
+	free_table(set->ctrl, set->slots, set->capacity);
 }
 
 static void set_free(GlowValue *this)
@@ -487,6 +865,31 @@ static void set_free(GlowValue *this)
 	glow_obj_class.del(this);
 }
 
+static void set_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowSetObject *set = glow_objvalue(this);
+	const size_t capacity = set->capacity;
+
+	for (size_t i = 0; i < capacity; i++) {
+		if (set->ctrl[i] >= 0) {
+			visit(&set->slots[i].element, arg);
+		}
+	}
+}
+
+static void set_clear(GlowValue *this)
+{
+	GlowSetObject *set = glow_objvalue(this);
+	signed char *ctrl = set->ctrl;
+	Entry *slots = set->slots;
+	const size_t capacity = set->capacity;
+
+	table_init(set, EMPTY_SIZE);
+	++set->state_id;
+
+	free_table(ctrl, slots, capacity);
+}
+
 struct glow_num_methods glow_set_num_methods = {
 	NULL,    /* plus */
 	NULL,    /* minus */
@@ -550,6 +953,10 @@ struct glow_seq_methods glow_set_seq_methods = {
 struct glow_attr_method set_methods[] = {
 	{"add", set_add_method},
 	{"remove", set_remove_method},
+	{"union", set_union_method},
+	{"intersection", set_intersection_method},
+	{"difference", set_difference_method},
+	{"update", set_update_method},
 	{NULL, NULL}
 };
 
@@ -563,6 +970,9 @@ GlowClass glow_set_class = {
 	.init = set_init,
 	.del = set_free,
 
+	.traverse = set_traverse,
+	.clear = set_clear,
+
 	.eq = set_eq,
 	.hash = NULL,
 	.cmp = NULL,
@@ -593,7 +1003,6 @@ static GlowValue iter_make(GlowSetObject *set)
 	glow_retaino(set);
 	iter->source = set;
 	iter->saved_state_id = set->state_id;
-	iter->current_entry = NULL;
 	iter->current_index = 0;
 	return glow_makeobj(iter);
 }
@@ -608,36 +1017,23 @@ static GlowValue iter_next(GlowValue *this)
 		return GLOW_ISC_EXC("set changed state during iteration");
 	}
 
-	Entry **entries = iter->source->entries;
-	Entry *entry = iter->current_entry;
+	GlowSetObject *set = iter->source;
+	const size_t capacity = set->capacity;
 	size_t idx = iter->current_index;
-	const size_t capacity = iter->source->capacity;
+
+	while (idx < capacity && set->ctrl[idx] < 0) {
+		++idx;
+	}
 
 	if (idx >= capacity) {
+		iter->current_index = capacity;
 		GLOW_EXIT(iter->source);
 		return glow_get_iter_stop();
 	}
 
-	if (entry == NULL) {
-		for (size_t i = idx; i < capacity; i++) {
-			if (entries[i] != NULL) {
-				entry = entries[i];
-				idx = i+1;
-				break;
-			}
-		}
-
-		if (entry == NULL) {
-			GLOW_EXIT(iter->source);
-			return glow_get_iter_stop();
-		}
-	}
-
-	GlowValue next = entry->element;
+	GlowValue next = set->slots[idx].element;
 	glow_retain(&next);
-
-	iter->current_index = idx;
-	iter->current_entry = entry->next;
+	iter->current_index = idx + 1;
 
 	GLOW_EXIT(iter->source);
 	return next;
@@ -30,6 +30,11 @@ GlowValue glow_strobj_make_direct(const char *value, const size_t len)
 	return glow_makeobj(s);
 }
 
+GlowValue glow_strobj_make_interned(const char *value, const size_t len)
+{
+	return glow_strobj_make(*glow_str_intern(value, len));
+}
+
 static GlowValue strobj_eq(GlowValue *this, GlowValue *other)
 {
 	if (!glow_is_a(other, &glow_str_class)) {
@@ -55,7 +60,7 @@ static GlowValue strobj_cmp(GlowValue *this, GlowValue *other)
 static GlowValue strobj_hash(GlowValue *this)
 {
 	GlowStrObject *s = glow_objvalue(this);
-	return glow_makeint(glow_str_hash(&s->str));
+	return glow_makehash(glow_str_hash(&s->str));
 }
 
 static bool strobj_nonzero(GlowValue *this)
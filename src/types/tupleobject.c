@@ -6,6 +6,7 @@
 #include "vmops.h"
 #include "object.h"
 #include "strobject.h"
+#include "gc.h"
 #include "tupleobject.h"
 
 #define INDEX_CHECK(index, count) \
@@ -20,6 +21,15 @@ GlowValue glow_tuple_make(GlowValue *elements, const size_t count)
 	GlowTupleObject *tup = glow_obj_alloc_var(&glow_tuple_class, extra_size);
 	memcpy(tup->elements, elements, extra_size);
 	tup->count = count;
+
+	/* being immutable, a tuple of no containers can't be part of a cycle */
+	for (size_t i = 0; i < count; i++) {
+		if (glow_isobject(&elements[i]) && ((GlowObject *)glow_objvalue(&elements[i]))->class->traverse != NULL) {
+			glow_gc_track(tup);
+			break;
+		}
+	}
+
 	return glow_makeobj(tup);
 }
 
@@ -83,6 +93,29 @@ static void tuple_free(GlowValue *this)
 	glow_obj_class.del(this);
 }
 
+static void tuple_traverse(GlowValue *this, GlowVisitFunc visit, void *arg)
+{
+	GlowTupleObject *tup = glow_objvalue(this);
+	GlowValue *elements = tup->elements;
+	const size_t count = tup->count;
+
+	for (size_t i = 0; i < count; i++) {
+		visit(&elements[i], arg);
+	}
+}
+
+static void tuple_clear(GlowValue *this)
+{
+	GlowTupleObject *tup = glow_objvalue(this);
+	GlowValue *elements = tup->elements;
+	const size_t count = tup->count;
+
+	tup->count = 0;
+	for (size_t i = 0; i < count; i++) {
+		glow_release(&elements[i]);
+	}
+}
+
 static GlowValue tuple_len(GlowValue *this)
 {
 	GlowTupleObject *tup = glow_objvalue(this);
@@ -175,6 +208,9 @@ GlowClass glow_tuple_class = {
 	.init = NULL,
 	.del = tuple_free,
 
+	.traverse = tuple_traverse,
+	.clear = tuple_clear,
+
 	.eq = NULL,
 	.hash = NULL,
 	.cmp = NULL,
@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "err.h"
+#include "util.h"
+#include "slab.h"
+
+/*
+ * Pages are PAGE_SIZE-aligned, so the page (and thereby the heap and
+ * size class) of a block can be found by masking its address.
+ */
+#define PAGE_SIZE   (16 * 1024)
+#define PAGE_HEADER 16
+
+struct block {
+	struct block *next;
+};
+
+struct heap;
+
+struct page {
+	struct heap *heap;
+	unsigned int size_class;
+};
+
+struct heap {
+	struct block *free[GLOW_SLAB_NUM_CLASSES + 1];
+
+	/* unused tail of each size class's newest page */
+	char *bump[GLOW_SLAB_NUM_CLASSES + 1];
+	char *bump_end[GLOW_SLAB_NUM_CLASSES + 1];
+
+	/* blocks freed by other threads, pushed lock-free */
+	_Atomic(struct block *) remote;
+
+	struct heap *next_abandoned;
+};
+
+_Static_assert(sizeof(struct page) <= PAGE_HEADER, "slab page header too large");
+
+static _Thread_local struct heap *thread_heap = NULL;
+
+/*
+ * Heaps of exited threads. Their pages may still hold live objects, so
+ * rather than being freed they are adopted by the next new thread.
+ */
+static struct heap *abandoned = NULL;
+static pthread_mutex_t abandoned_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define PAGE_OF(p) ((struct page *)((uintptr_t)(p) & ~(uintptr_t)(PAGE_SIZE - 1)))
+
+static struct heap *heap_get(void)
+{
+	struct heap *heap = thread_heap;
+
+	if (heap != NULL) {
+		return heap;
+	}
+
+	GLOW_SAFE(pthread_mutex_lock(&abandoned_mutex));
+	heap = abandoned;
+	if (heap != NULL) {
+		abandoned = heap->next_abandoned;
+	}
+	GLOW_SAFE(pthread_mutex_unlock(&abandoned_mutex));
+
+	if (heap == NULL) {
+		heap = glow_calloc(1, sizeof(struct heap));
+	}
+
+	heap->next_abandoned = NULL;
+	thread_heap = heap;
+	return heap;
+}
+
+static void drain_remote(struct heap *heap)
+{
+	struct block *b = atomic_exchange_explicit(&heap->remote, NULL, memory_order_acquire);
+
+	while (b != NULL) {
+		struct block *next = b->next;
+		const unsigned int size_class = PAGE_OF(b)->size_class;
+		b->next = heap->free[size_class];
+		heap->free[size_class] = b;
+		b = next;
+	}
+}
+
+static void *alloc_slow(struct heap *heap, const unsigned int size_class)
+{
+	if (atomic_load_explicit(&heap->remote, memory_order_relaxed) != NULL) {
+		drain_remote(heap);
+
+		struct block *b = heap->free[size_class];
+		if (b != NULL) {
+			heap->free[size_class] = b->next;
+			return b;
+		}
+	}
+
+	const size_t size = size_class * GLOW_SLAB_GRANULE;
+
+	if (heap->bump[size_class] == NULL || heap->bump[size_class] + size > heap->bump_end[size_class]) {
+		struct page *page = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+
+		if (page == NULL) {
+			GLOW_INTERNAL_ERROR();
+		}
+
+		page->heap = heap;
+		page->size_class = size_class;
+		heap->bump[size_class] = (char *)page + PAGE_HEADER;
+		heap->bump_end[size_class] = (char *)page + PAGE_SIZE;
+	}
+
+	void *p = heap->bump[size_class];
+	heap->bump[size_class] += size;
+	return p;
+}
+
+void *glow_slab_alloc(unsigned int size_class)
+{
+	struct heap *heap = heap_get();
+	struct block *b = heap->free[size_class];
+
+	if (b != NULL) {
+		heap->free[size_class] = b->next;
+		return b;
+	}
+
+	return alloc_slow(heap, size_class);
+}
+
+void glow_slab_free(void *p)
+{
+	struct page *page = PAGE_OF(p);
+	struct heap *heap = page->heap;
+	struct block *b = p;
+
+	if (heap == thread_heap) {
+		b->next = heap->free[page->size_class];
+		heap->free[page->size_class] = b;
+	} else {
+		struct block *head = atomic_load_explicit(&heap->remote, memory_order_relaxed);
+		do {
+			b->next = head;
+		} while (!atomic_compare_exchange_weak_explicit(&heap->remote, &head, b,
+		                                                memory_order_release, memory_order_relaxed));
+	}
+}
+
+/* must be called by threads that may have allocated objects before they exit */
+void glow_slab_thread_exit(void)
+{
+	struct heap *heap = thread_heap;
+
+	if (heap == NULL) {
+		return;
+	}
+
+	thread_heap = NULL;
+
+	GLOW_SAFE(pthread_mutex_lock(&abandoned_mutex));
+	heap->next_abandoned = abandoned;
+	abandoned = heap;
+	GLOW_SAFE(pthread_mutex_unlock(&abandoned_mutex));
+}
@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <pthread.h>
+#include "err.h"
 #include "util.h"
 #include "str.h"
 
@@ -13,6 +15,7 @@ GlowStr *glow_str_new(const char *value, const size_t len)
 	str->hash = 0;
 	str->hashed = 0;
 	str->freeable = 0;
+	str->interned = 0;
 	return str;
 }
 
@@ -28,6 +31,7 @@ GlowStr *glow_str_new_copy(const char *value, const size_t len)
 	str->hash = 0;
 	str->hashed = 0;
 	str->freeable = 0;
+	str->interned = 0;
 
 	return str;
 }
@@ -38,6 +42,14 @@ bool glow_str_eq(GlowStr *s1, GlowStr *s2)
 		return false;
 	}
 
+	if (s1->value == s2->value) {
+		return true;
+	}
+
+	if (s1->interned && s2->interned) {
+		return false;
+	}
+
 	return memcmp(s1->value, s2->value, s1->len) == 0;
 }
 
@@ -87,6 +99,81 @@ void glow_str_free(GlowStr *str)
 	free(str);
 }
 
+/*
+ * Intern table: open addressing over pointers to interned strings, each
+ * allocated together with its characters. Entries are never removed.
+ */
+#define INTERN_INIT_CAPACITY 256
+
+static const GlowStr **intern_table = NULL;
+static size_t intern_count = 0;
+static size_t intern_capacity = 0;
+static pthread_mutex_t intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void intern_resize(const size_t new_capacity)
+{
+	const GlowStr **new_table = glow_calloc(new_capacity, sizeof(GlowStr *));
+	const size_t mask = new_capacity - 1;
+
+	for (size_t i = 0; i < intern_capacity; i++) {
+		const GlowStr *str = intern_table[i];
+
+		if (str == NULL) {
+			continue;
+		}
+
+		size_t j = (size_t)glow_util_hash_secondary(str->hash) & mask;
+		while (new_table[j] != NULL) {
+			j = (j + 1) & mask;
+		}
+		new_table[j] = str;
+	}
+
+	free(intern_table);
+	intern_table = new_table;
+	intern_capacity = new_capacity;
+}
+
+const GlowStr *glow_str_intern(const char *value, const size_t len)
+{
+	const int hash = glow_util_hash_cstr2(value, len);
+	const GlowStr *ret;
+
+	GLOW_SAFE(pthread_mutex_lock(&intern_mutex));
+
+	if (intern_count >= intern_capacity / 2) {
+		intern_resize(intern_capacity ? 2 * intern_capacity : INTERN_INIT_CAPACITY);
+	}
+
+	const size_t mask = intern_capacity - 1;
+	size_t i = (size_t)glow_util_hash_secondary(hash) & mask;
+
+	while ((ret = intern_table[i]) != NULL) {
+		if (ret->hash == hash && ret->len == len && memcmp(ret->value, value, len) == 0) {
+			goto done;
+		}
+		i = (i + 1) & mask;
+	}
+
+	GlowStr *str = glow_malloc(sizeof(GlowStr) + len + 1);
+	char *copy = (char *)(str + 1);
+	memcpy(copy, value, len);
+	copy[len] = '\0';
+
+	*str = GLOW_STR_INIT(copy, len, 0);
+	str->hash = hash;
+	str->hashed = 1;
+	str->interned = 1;
+
+	intern_table[i] = str;
+	++intern_count;
+	ret = str;
+
+done:
+	GLOW_SAFE(pthread_mutex_unlock(&intern_mutex));
+	return ret;
+}
+
 void glow_util_str_array_dup(struct glow_str_array *src, struct glow_str_array *dst)
 {
 	const size_t length = src->length;
@@ -5,46 +5,59 @@
 #include "strdict.h"
 
 #define STRDICT_INIT_TABLE_SIZE  32
-#define STRDICT_LOAD_FACTOR      0.75f
 
-#define HASH(key)  (glow_util_hash_secondary(glow_str_hash((key))))
+/* max. load factor of 1/2; tables are small, and short probes matter more */
+#define STRDICT_MAX_LOAD(cap)    ((cap) / 2)
+
+#define SLOT(hash, mask)  ((size_t)glow_util_hash_secondary((hash)) & (mask))
 
 typedef GlowStrDictEntry Entry;
 
-static Entry **make_empty_table(const size_t capacity);
 static void strdict_resize(GlowStrDict *dict, const size_t new_capacity);
 
+static Entry *make_empty_table(const size_t capacity)
+{
+	return glow_calloc(capacity, sizeof(Entry));
+}
+
 void glow_strdict_init(GlowStrDict *dict)
 {
 	dict->table = make_empty_table(STRDICT_INIT_TABLE_SIZE);
 	dict->count = 0;
 	dict->capacity = STRDICT_INIT_TABLE_SIZE;
-	dict->threshold = (size_t)(STRDICT_INIT_TABLE_SIZE * STRDICT_LOAD_FACTOR);
 }
 
-static Entry *make_entry(GlowStr *key, const int hash, GlowValue *value)
+static inline bool key_eq(GlowStr *key, const int hash, Entry *entry)
 {
-	Entry *entry = glow_malloc(sizeof(Entry));
-	entry->key = *key;
-	entry->hash = hash;
-	entry->value = *value;
-	entry->next = NULL;
-	return entry;
+	return entry->key.hash == hash &&
+	       (entry->key.value == key->value || glow_str_eq(key, &entry->key));
 }
 
-GlowValue glow_strdict_get(GlowStrDict *dict, GlowStr *key)
+/* the slot holding `key`, or the empty slot it would go in */
+static Entry *find(GlowStrDict *dict, GlowStr *key)
 {
-	const int hash = HASH(key);
-	for (Entry *entry = dict->table[hash & (dict->capacity - 1)];
-	     entry != NULL;
-	     entry = entry->next) {
+	const int hash = glow_str_hash(key);
+	const size_t mask = dict->capacity - 1;
+	Entry *table = dict->table;
 
-		if (hash == entry->hash && glow_str_eq(key, &entry->key)) {
-			return entry->value;
+	for (size_t i = SLOT(hash, mask); true; i = (i + 1) & mask) {
+		Entry *entry = &table[i];
+
+		if (entry->key.value == NULL || key_eq(key, hash, entry)) {
+			return entry;
 		}
 	}
+}
+
+GlowValue glow_strdict_get(GlowStrDict *dict, GlowStr *key)
+{
+	/* uninitialized builtin modules have no table */
+	if (dict->count == 0) {
+		return glow_makeempty();
+	}
 
-	return glow_makeempty();
+	Entry *entry = find(dict, key);
+	return (entry->key.value != NULL) ? entry->value : glow_makeempty();
 }
 
 GlowValue glow_strdict_get_cstr(GlowStrDict *dict, const char *key)
@@ -53,39 +66,31 @@ GlowValue glow_strdict_get_cstr(GlowStrDict *dict, const char *key)
 	return glow_strdict_get(dict, &key_str);
 }
 
-void glow_strdict_put(GlowStrDict *dict, const char *key, GlowValue *value, bool key_freeable)
+static void put(GlowStrDict *dict, const GlowStr *key, GlowValue *value)
 {
-	GlowStr key_str = GLOW_STR_INIT(key, strlen(key), (key_freeable ? 1 : 0));
-	Entry **table = dict->table;
-	const size_t capacity = dict->capacity;
-	const int hash = HASH(&key_str);
-	const size_t index = hash & (capacity - 1);
+	GlowStr key_str = *key;
+	Entry *entry = find(dict, &key_str);
 
-	for (Entry *entry = table[index];
-	     entry != NULL;
-	     entry = entry->next) {
-
-		if (hash == entry->hash && glow_str_eq(&key_str, &entry->key)) {
-			glow_release(&entry->value);
+	if (entry->key.value != NULL) {
+		glow_release(&entry->value);
+		entry->value = *value;
+		return;
+	}
 
-			if (entry->key.freeable) {
-				glow_str_dealloc(&entry->key);
-			}
+	entry->key = key_str;
+	entry->value = *value;
 
-			entry->key = key_str;
-			entry->value = *value;
-			return;
-		}
+	if (++dict->count > STRDICT_MAX_LOAD(dict->capacity)) {
+		strdict_resize(dict, 2 * dict->capacity);
 	}
+}
 
-	Entry *entry = make_entry(&key_str, hash, value);
-	entry->next = table[index];
-	table[index] = entry;
+void glow_strdict_put(GlowStrDict *dict, const char *key, GlowValue *value, bool key_freeable)
+{
+	put(dict, glow_str_intern(key, strlen(key)), value);
 
-	if (dict->count++ >= dict->threshold) {
-		const size_t new_capacity = 2 * capacity;
-		strdict_resize(dict, new_capacity);
-		dict->threshold = (size_t)(new_capacity * STRDICT_LOAD_FACTOR);
+	if (key_freeable) {
+		GLOW_FREE(key);
 	}
 }
 
@@ -94,56 +99,47 @@ void glow_strdict_put_copy(GlowStrDict *dict, const char *key, size_t len, GlowV
 	if (len == 0) {
 		len = strlen(key);
 	}
-	char *key_copy = glow_malloc(len + 1);
-	strcpy(key_copy, key);
-	glow_strdict_put(dict, key_copy, value, true);
+	put(dict, glow_str_intern(key, len), value);
 }
 
 void glow_strdict_dealloc(GlowStrDict *dict)
 {
-	Entry **table = dict->table;
+	Entry *table = dict->table;
 	const size_t capacity = dict->capacity;
 
 	for (size_t i = 0; i < capacity; i++) {
-		Entry *entry = table[i];
-		while (entry != NULL) {
-			Entry *temp = entry;
-			entry = entry->next;
-			glow_release(&temp->value);
-			if (temp->key.freeable) {
-				glow_str_dealloc(&temp->key);
-			}
-			free(temp);
+		Entry *entry = &table[i];
+
+		if (entry->key.value == NULL) {
+			continue;
 		}
+
+		glow_release(&entry->value);
 	}
 
 	free(table);
 }
 
-static Entry **make_empty_table(const size_t capacity)
-{
-	Entry **table = glow_malloc(capacity * sizeof(Entry *));
-	for (size_t i = 0; i < capacity; i++) {
-		table[i] = NULL;
-	}
-	return table;
-}
-
 static void strdict_resize(GlowStrDict *dict, const size_t new_capacity)
 {
 	const size_t old_capacity = dict->capacity;
-	Entry **old_table = dict->table;
-	Entry **new_table = make_empty_table(new_capacity);
+	Entry *old_table = dict->table;
+	Entry *new_table = make_empty_table(new_capacity);
+	const size_t mask = new_capacity - 1;
 
 	for (size_t i = 0; i < old_capacity; i++) {
-		Entry *entry = old_table[i];
-		while (entry != NULL) {
-			Entry *next = entry->next;
-			const size_t index = entry->hash & (new_capacity - 1);
-			entry->next = new_table[index];
-			new_table[index] = entry;
-			entry = next;
+		Entry *entry = &old_table[i];
+
+		if (entry->key.value == NULL) {
+			continue;
+		}
+
+		size_t j = SLOT(entry->key.hash, mask);
+		while (new_table[j].key.value != NULL) {
+			j = (j + 1) & mask;
 		}
+
+		new_table[j] = *entry;
 	}
 
 	free(old_table);